@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Types.hpp"
+#include "IS.hpp"
+
+namespace tca {
+
+// Which dimensions to group fills by. A disabled dimension collapses to a
+// single bucket with index 0.
+struct AttributionSpec {
+  bool by_venue = true;
+  double time_bucket_s = 0.0;       // <= 0 disables the time dimension
+  std::vector<double> size_edges;   // ascending fill-qty edges; empty disables
+  bool by_side = false;
+};
+
+struct AttributionCell {
+  int venue = 0;          // index into ISAttribution::venues
+  int time_bucket = 0;    // bucket k starts at time_origin + k * time_bucket_s
+  int size_bucket = 0;    // qty < size_edges[0] -> 0, ..., >= size_edges.back() -> edges.size()
+  int side = 0;           // +1 / -1 when by_side, else 0
+  std::size_t fills = 0;
+  double qty = 0.0;
+  double notional = 0.0;
+  // Contributions in bps of the whole order's arrival notional, so summing a
+  // component over all cells reproduces compute_is for that component.
+  ISBreakdown contrib{};
+};
+
+struct ISAttribution {
+  AttributionSpec spec;
+  std::vector<std::string> venues;
+  double time_origin = 0.0;
+  std::vector<AttributionCell> cells;   // non-empty cells only, in table order
+  ISBreakdown total{};
+};
+
+// Upper bound on venues x time buckets x size buckets x sides.
+constexpr std::size_t kMaxAttributionCells = std::size_t{1} << 24;
+
+// Accumulates fills into a table indexed by (venue, time bucket, size
+// bucket, side), after a key pass that interns venues. Uses compute_is
+// conventions (arrival p0, end mid = snaps.back(), timing sign from the
+// first fill). Chunks run in parallel into sparse partials merged in the
+// fixed deterministic_reduce tree, so the table is bit-identical for any
+// thread count. Throws std::invalid_argument if the table would exceed
+// kMaxAttributionCells.
+ISAttribution attribute_is(const Fills& fills, const Snaps& snaps, double p0,
+                           const AttributionSpec& spec, unsigned threads = 1);
+
+} // namespace tca
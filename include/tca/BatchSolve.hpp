@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace tca {
+
+// A batch of k x k symmetric positive definite systems stored interleaved
+// (structure of arrays): element (i, j) of system b lives at
+// A[(i*k + j) * batch + b] and rhs element i at rhs[i * batch + b]. Every
+// inner loop of the solver then runs over b with unit stride, so the
+// compiler packs several independent systems into each SIMD register.
+struct BatchedSPD {
+  int k = 0;
+  std::size_t batch = 0;
+  std::vector<double> A;
+  std::vector<double> rhs;
+
+  BatchedSPD() = default;
+  BatchedSPD(int k_, std::size_t batch_)
+    : k(k_), batch(batch_),
+      A(static_cast<std::size_t>(k_ * k_) * batch_, 0.0),
+      rhs(static_cast<std::size_t>(k_) * batch_, 0.0) {}
+
+  double& a(int i, int j, std::size_t b) { return A[static_cast<std::size_t>(i * k + j) * batch + b]; }
+  double& r(int i, std::size_t b)        { return rhs[static_cast<std::size_t>(i) * batch + b]; }
+};
+
+struct BatchedSolution {
+  std::vector<double> x;          // same interleaving as rhs
+  std::vector<double> inv_diag;   // diag(A^-1), same interleaving as rhs
+  std::vector<unsigned char> ok;  // 0 where a pivot was not positive
+
+  double at(int i, std::size_t b, std::size_t batch) const { return x[static_cast<std::size_t>(i) * batch + b]; }
+  double inv(int i, std::size_t b, std::size_t batch) const { return inv_diag[static_cast<std::size_t>(i) * batch + b]; }
+};
+
+// Interleaved Cholesky over the whole batch, in cache-sized tiles. A is
+// overwritten by L (lower triangle). A system whose pivot drops below
+// 1e-12 of its original diagonal is flagged in ok and continues with a unit
+// pivot so the batch stays branch-free; its x and inv_diag are meaningless.
+void batched_cholesky_solve(BatchedSPD& sys, BatchedSolution& out);
+
+} // namespace tca
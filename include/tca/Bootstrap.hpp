@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Types.hpp"
+#include "Impact.hpp"
+
+namespace tca {
+
+// Additive dollar components of IS for one resampling unit (an order or a
+// single fill). Units from different orders can be pooled: summing any
+// subset and dividing by the summed denom gives the pooled breakdown.
+struct ISPartials {
+  double denom  = 0.0;   // qty * p0
+  double is     = 0.0;   // side * (paid - qty * p0); positive = cost
+  double spread = 0.0;
+  double fees   = 0.0;
+  double timing = 0.0;
+};
+
+// compute_is conventions (p0, end mid = snaps.back(), timing sign from the first fill).
+ISPartials is_partials(const Fills& fills, const Snaps& snaps, double p0);
+std::vector<ISPartials> is_fill_partials(const Fills& fills, const Snaps& snaps, double p0);
+
+enum class ISWeighting {
+  Notional,   // sum of dollars / sum of denom over the resample
+  Equal       // plain mean of each unit's own bps
+};
+
+struct BootstrapConfig {
+  std::size_t replicates = 2000;
+  std::uint64_t seed = 42;
+  unsigned threads = 0;        // 0 = hardware concurrency
+  double alpha = 0.05;         // two-sided; 0.05 -> 95% percentile interval
+  ISWeighting weighting = ISWeighting::Notional;
+};
+
+struct Interval {
+  double estimate = 0.0;   // statistic on the original sample
+  double se = 0.0;         // std. dev. of the replicates
+  double lo = 0.0;
+  double hi = 0.0;
+};
+
+struct ISBootstrap {
+  Interval is, spread, fees, timing, residual;
+  std::size_t units = 0;
+  std::size_t replicates = 0;
+};
+
+// Percentile bootstrap over units. Each replicate costs O(units); draws come
+// from a counter-based generator keyed by (seed, replicate), so results are
+// identical for any thread count.
+ISBootstrap bootstrap_is(const std::vector<ISPartials>& units, const BootstrapConfig& cfg);
+
+struct ImpactBootstrap {
+  std::vector<Interval> coef;   // one per column of the blocks' Gram
+  Interval eta;                 // coef[1] scaled to bps per 10% POV
+  std::size_t blocks = 0;
+  std::size_t replicates = 0;   // replicates that produced a solvable X'X
+  std::size_t singular = 0;     // replicates dropped because X'X was singular
+};
+
+// Block bootstrap of the temporary-impact coefficients. Each block (an
+// order, or a time bucket from daily_impact_stats) is reduced to its Gram
+// contribution up front, so a replicate sums B drawn k x k blocks and
+// solves; no pass over fills. Same seeding and threading as bootstrap_is.
+ImpactBootstrap bootstrap_impact(const std::vector<NormalEquations>& blocks, const BootstrapConfig& cfg);
+
+} // namespace tca
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include "Types.hpp"
+#include "Impact.hpp"
 
 namespace tca {
 
@@ -11,4 +12,7 @@ Fills load_fills_csv(const std::string& path);
 // mkt.csv: ts,mid,spread_bps,vol_est,sigma
 Snaps load_snaps_csv(const std::string& path);
 
+// impact.json: {"eta_bp_per_10pov", "gamma_bp_per_10pov", "beta"}; missing keys keep defaults.
+ImpactParams load_impact_json(const std::string& path);
+
 } // namespace tca
@@ -14,8 +14,54 @@ namespace tca {
         double residual_bps;
     };
 
+    // Raw dollar sums over fills; everything compute_is needs besides p0 and the end mid.
+    struct ISSums {
+        double qty    = 0.0;
+        double paid   = 0.0;
+        double spread = 0.0;   // sum of max(0, side * (px - mid)) * qty
+        double fees   = 0.0;   // sum of qty * px * fee_bps / 1e4
+    };
+
+    // All components are signed so that positive is a cost for side_sign:
+    // is = side * (paid - qty * p0), timing = side * qty * (mid_end - p0).
+    ISBreakdown finalize_is(const ISSums& s, double p0, double mid_end, int side_sign);
+
+    // Columnar SIMD kernel (ISKernel.hpp) at the widest level the CPU supports.
     ISBreakdown compute_is(const std::vector<Fill>& fills, const std::vector<Snap>& snaps, double arrival_time);
 
+    // Per-fill scalar loop with a binary-search mid lookup; the reference the
+    // kernels are checked against (tca is-check).
+    ISBreakdown compute_is_scalar(const std::vector<Fill>& fills, const std::vector<Snap>& snaps, double arrival_time);
+
+    // Reference prices for one order. A benchmark that cannot be formed
+    // (no market volume for VWAP, no previous close supplied) is NaN.
+    struct BenchmarkPrices {
+        double arrival;
+        double interval_vwap;  // volume-weighted mid of snaps in force over [first fill, last fill]
+        double interval_twap;  // time-weighted mid over the same interval
+        double open;           // first snap's mid
+        double prev_close;     // caller supplied
+        double end_mid;        // mid at or before the last fill
+    };
+
+    // Slippage of the order's average price against each benchmark, in bps,
+    // signed so that a positive number is a cost for the order's side.
+    struct BenchmarkIS {
+        ISBreakdown arrival;   // as compute_is, but timing is measured to end_mid
+        BenchmarkPrices px;
+        double avg_px;
+        double vs_arrival_bps;
+        double vs_vwap_bps;
+        double vs_twap_bps;
+        double vs_open_bps;
+        double vs_prev_close_bps;
+        double vs_end_bps;
+    };
+
+    // All benchmarks from one merged walk over time-sorted fills and snaps.
+    BenchmarkIS compute_is_benchmarks(const std::vector<Fill>& fills, const std::vector<Snap>& snaps,
+                                      double p0, double prev_close);
+
     double infer_arrival_mid(const std::vector<Fill>& fills, const std::vector<Snap>& snaps);
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "Types.hpp"
+#include "IS.hpp"
+
+namespace tca {
+
+// Structure-of-arrays view of an order's fills with the as-of mid already
+// joined in, so the IS sums reduce to straight-line arithmetic per element.
+struct FillColumns {
+  std::vector<double> qty;
+  std::vector<double> px;
+  std::vector<double> sign;     // +1 BUY, -1 SELL
+  std::vector<double> fee_bps;
+  std::vector<double> mid;      // mid_at_or_before(snaps, fill.time)
+
+  std::size_t size() const { return qty.size(); }
+};
+
+// Fills must be time-sorted (load_fills_csv guarantees it); the mid join is a
+// single forward merge against the snaps rather than a binary search per fill.
+FillColumns make_fill_columns(const Fills& fills, const Snaps& snaps);
+
+enum class SimdLevel { Scalar, AVX2, AVX512 };
+
+// Widest kernel the running CPU supports; resolved once on first call.
+SimdLevel active_simd_level();
+const char* to_string(SimdLevel level);
+
+// ISSums over rows [begin, end) using the given kernel. Lanes are summed in a
+// different order than compute_is, so results agree to rounding, not bitwise.
+ISSums is_sums_columnar(const FillColumns& C, std::size_t begin, std::size_t end, SimdLevel level);
+ISSums is_sums_columnar(const FillColumns& C, std::size_t begin, std::size_t end);
+
+// ISSums over all rows via deterministic_reduce: SIMD within fixed chunks,
+// pairwise across chunks. Bit-identical for any thread count.
+ISSums is_sums_parallel(const FillColumns& C, unsigned threads);
+
+// Vectorized counterpart of compute_is_scalar (same p0 / end-mid / side
+// conventions); compute_is calls this.
+ISBreakdown compute_is_columnar(const FillColumns& C, const Snaps& snaps, double p0, unsigned threads = 1);
+
+// Single-threaded, at a given kernel level (for checking levels below the
+// active one).
+ISBreakdown compute_is_columnar(const FillColumns& C, const Snaps& snaps, double p0, SimdLevel level);
+
+// Largest |difference| in bps over the five ISBreakdown components between
+// each kernel and compute_is_scalar. Levels the CPU lacks are NaN;
+// `parallel` is the chunked multi-threaded path at the active level.
+struct ISKernelCheck {
+  double scalar = 0.0;
+  double avx2 = 0.0;
+  double avx512 = 0.0;
+  double parallel = 0.0;
+};
+ISKernelCheck check_is_kernels(const Fills& fills, const Snaps& snaps, double p0, unsigned threads);
+
+} // namespace tca
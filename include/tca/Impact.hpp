@@ -3,6 +3,8 @@
 #include <vector>
 #include <cstddef>
 #include <cmath>
+#include <algorithm>
+#include <limits>
 #include <Eigen/Dense>
 #include "Types.hpp"
 
@@ -11,26 +13,212 @@ namespace tca {
 struct ImpactParams {
   double eta_bp_per_10pov   = 0.0;
   double gamma_bp_per_10pov = 0.0;
+  // Temporary impact ~ eta * (POV / 10%)^beta; beta = 1 is the linear model.
+  double beta = 1.0;
 };
 
 inline double pov(double slice_qty, double vol_est_i) {
   return (vol_est_i > 0.0) ? std::abs(slice_qty) / vol_est_i : 0.0;
 }
 
+inline int temp_impact_columns(bool include_spread_control, bool include_sigma_control) {
+  return 2 + (include_spread_control ? 1 : 0) + (include_sigma_control ? 1 : 0);
+}
+
+// One temporary-impact row from a fill and the snap in force at its time
+// (mid and volume both come from sref). Columns: [1, signed_pov, spread?, sigma?];
+// y is signed slippage in bps. Returns the number of columns written.
+inline int temp_impact_row(const Fill& f, const Snap& sref,
+                           bool include_spread_control, bool include_sigma_control,
+                           double* x, double& y) {
+  const double s = (f.side == Side::BUY) ? +1.0 : -1.0;
+  y = s * (f.px - sref.mid) / sref.mid * 1e4;
+  int c = 0;
+  x[c++] = 1.0;                          // intercept
+  x[c++] = s * pov(f.qty, sref.volume);  // main regressor
+  if (include_spread_control) x[c++] = sref.spread_bps;
+  if (include_sigma_control)  x[c++] = sref.sigma;
+  return c;
+}
+
+// Columnar fills for multi-pass fitters (power law, IRLS): everything
+// temp_impact_row derives from a fill and its as-of snap, one array each.
+struct ImpactColumns {
+  std::vector<double> sign;      // +1 BUY, -1 SELL
+  std::vector<double> pov;       // unsigned POV against the as-of snap volume
+  std::vector<double> spread;    // snap spread_bps
+  std::vector<double> sigma;     // snap sigma
+  std::vector<double> y;         // signed slippage vs as-of mid, bps
+
+  std::size_t size() const { return y.size(); }
+};
+
+ImpactColumns build_impact_columns(const Fills& fills, const Snaps& snaps);
+
 struct RegrData {
   Eigen::MatrixXd X;         
   Eigen::VectorXd y;         
   std::vector<std::size_t> kept_rows; 
 };
 
+// Sufficient statistics of a linear regression: X'X, X'y, y'y and row count.
+// Partials over disjoint row sets merge by addition.
+struct NormalEquations {
+  Eigen::MatrixXd XtX;
+  Eigen::VectorXd Xty;
+  double yty = 0.0;
+  std::size_t n = 0;
+
+  NormalEquations() = default;
+  explicit NormalEquations(Eigen::Index k)
+    : XtX(Eigen::MatrixXd::Zero(k, k)), Xty(Eigen::VectorXd::Zero(k)) {}
+
+  Eigen::Index k() const { return Xty.size(); }
+  void merge(const NormalEquations& o) { XtX += o.XtX; Xty += o.Xty; yty += o.yty; n += o.n; }
+
+  // Rank-one update with one row (x has k() entries).
+  void add(const double* x, double y, double w = 1.0) {
+    const Eigen::Index K = k();
+    for (Eigen::Index a = 0; a < K; ++a) {
+      const double wxa = w * x[a];
+      for (Eigen::Index b = 0; b < K; ++b) XtX(a, b) += wxa * x[b];
+      Xty(a) += wxa * y;
+    }
+    yty += w * y * y;
+    ++n;
+  }
+};
+
+// Coefficients plus classical OLS diagnostics. Column 0 is assumed to be the
+// intercept and column 1 signed POV, as in build_temp_impact_design.
+struct ImpactFit {
+  ImpactParams params;
+  Eigen::VectorXd coef;
+  Eigen::VectorXd se;       // sqrt(diag(sigma2 * (X'X)^-1))
+  double sigma2 = 0.0;      // residual variance, SSE / (n - k)
+  double r2 = 0.0;
+  std::size_t n = 0;
+  std::vector<int> aliased; // columns dropped as combinations of earlier ones (coef 0, se NaN)
+};
+
+// Classical OLS diagnostics from the sums for coefficients b, with
+// inv_diag = diag((X'X)^-1) and k_used the columns actually estimated:
+// SSE = y'y - 2 b'X'y + b'X'X b, sigma2 = SSE / (n - k_used), R2 against the
+// intercept column's mean, se = sqrt(sigma2 * inv_diag) (NaN on fit.aliased).
+// Templated on the matrix type so the dynamic, fixed-size and batched
+// solvers share it.
+template <class Mat, class Vec, class Diag>
+void ols_diagnostics(const Mat& XtX, const Vec& Xty, double yty, std::size_t n,
+                     const Vec& b, const Diag& inv_diag, Eigen::Index k_used, ImpactFit& fit) {
+  const double sse = std::max(0.0, yty - 2.0 * b.dot(Xty) + b.dot(XtX * b));
+  const double nn = static_cast<double>(n);
+  const double ybar = Xty(0) / nn;               // intercept column sums y
+  const double sst = yty - nn * ybar * ybar;
+  fit.n = n;
+  fit.coef = b;
+  fit.sigma2 = sse / (nn - static_cast<double>(k_used));
+  fit.r2 = (sst > 0.0) ? 1.0 - sse / sst : 0.0;
+  fit.se = (fit.sigma2 * inv_diag).cwiseMax(0.0).cwiseSqrt();
+  for (int a : fit.aliased) fit.se(a) = std::numeric_limits<double>::quiet_NaN();
+  fit.params.eta_bp_per_10pov = b(1) * 0.1;
+}
+
+// Columns of a Gram matrix that are numerically linear combinations of
+// earlier ones: an in-order Cholesky sweep skips a column whose pivot falls
+// below tol times its diagonal. Earlier columns win, so in the layout above
+// a constant control is dropped rather than the intercept.
+std::vector<int> aliased_columns(const Eigen::MatrixXd& XtX, double tol = 1e-10);
+
+// LDLT solve of A b = r on the columns not in `aliased`; b is 0 on those.
+// inv (optional) gets the reduced inverse scattered back, zero on aliased
+// rows and columns. False if the reduced system is still not positive definite.
+bool solve_unaliased(const Eigen::MatrixXd& A, const Eigen::VectorXd& r,
+                     const std::vector<int>& aliased,
+                     Eigen::VectorXd& b, Eigen::MatrixXd* inv = nullptr);
+
+// Solve the k x k system (LDLT) and derive diagnostics from the sums alone.
+// Aliased controls (e.g. a constant sigma) are dropped and listed in the fit,
+// matching the pivoted QR of the dense path; throws if POV itself is aliased.
+ImpactFit solve_normal_equations(const NormalEquations& ne);
+
+// Name of temp-impact column c under the given control flags.
+const char* temp_impact_column_name(int c, bool include_spread_control, bool include_sigma_control);
+
+// Streaming equivalent of build_temp_impact_design + OLS: one as-of merge over
+// fills straight into X'X / X'y, O(k^2) memory regardless of the fill count.
+NormalEquations accumulate_temp_impact(const Fills& fills,
+                                       const Snaps& snaps,
+                                       bool include_spread_control = true,
+                                       bool include_sigma_control  = true);
+
+// Parallel variant: time-sorted fills are cut into contiguous chunks
+// (plan_chunks), each worker seeks its own as-of cursor and accumulates a
+// fixed-size 4x4 Gram, and partials are merged by deterministic_reduce, so
+// the sums are bit-identical for any thread count.
+NormalEquations accumulate_temp_impact_parallel(const Fills& fills,
+                                                const Snaps& snaps,
+                                                bool include_spread_control,
+                                                bool include_sigma_control,
+                                                unsigned threads);
+
+// X'X / X'y of an existing design, reduced over fixed row chunks with
+// deterministic_reduce: bit-identical for any thread count.
+NormalEquations gram_sums(const Eigen::MatrixXd& X, const Eigen::VectorXd& y, unsigned threads = 1);
+
 RegrData build_temp_impact_design(const Fills& fills,
                                   const Snaps& snaps,
                                   bool include_spread_control = true,
                                   bool include_sigma_control  = true);
 
+// Slice-bucketed design: fills are aggregated into the snap interval they
+// fall in (one row per interval and side), so POV is the realized interval
+// participation sum(qty) / snap.volume and y is the signed slippage of the
+// bucket's VWAP against the interval's opening mid. Same columns as
+// build_temp_impact_design; kept_rows holds the snap index of each row.
+// Fills must be time-sorted.
+RegrData build_bucketed_impact_design(const Fills& fills,
+                                      const Snaps& snaps,
+                                      bool include_spread_control = true,
+                                      bool include_sigma_control  = true);
+
 ImpactParams fit_temporary_impact_ols(const Eigen::MatrixXd& X,
                                       const Eigen::VectorXd& y);
 
+// Multi-symbol backend: one OLS per system, all solved together by the
+// interleaved batch Cholesky (BatchSolve.hpp) instead of a dynamic Eigen
+// factorization each. Systems must share k; one the Cholesky rejects is
+// refitted by solve_normal_equations (aliased controls dropped), and one with
+// n <= k or aliased POV comes back with NaN coef and se.
+std::vector<ImpactFit> fit_temporary_impact_ols(const std::vector<NormalEquations>& systems);
+
+// Split a time-sorted fill stream into parent orders: a new order starts
+// when the side flips or the gap since the previous fill exceeds gap_s.
+std::vector<Fills> split_orders(const Fills& fills, double gap_s);
+
+// Order-level permanent-impact design. One row per order:
+//   X = [1, signed participation]   (side * Q / market volume over the order)
+//   Y(:, h) = side * (mid(t_last + horizon_h) - mid(arrival)) / mid(arrival), in bps
+// Orders whose longest markout runs past the market data are dropped.
+struct PermRegrData {
+  Eigen::MatrixXd X;
+  Eigen::MatrixXd Y;
+  std::vector<double> horizons_s;
+  std::vector<std::size_t> kept_orders;
+};
+
+PermRegrData build_perm_impact_design(const std::vector<Fills>& orders,
+                                      const Snaps& snaps,
+                                      const std::vector<double>& horizons_s);
+
+struct PermanentImpactFit {
+  std::vector<double> horizons_s;
+  std::vector<double> gamma_bp_per_10pov;   // one per horizon
+};
+
+// All horizons from one QR of Xp: each column of Yp is a right-hand side.
+PermanentImpactFit fit_permanent_impact_multi(const PermRegrData& D);
+
+// Single-horizon form: yp is one markout column; fills gamma_bp_per_10pov.
 ImpactParams fit_permanent_impact_ols(const Eigen::MatrixXd& Xp,
                                       const Eigen::VectorXd& yp);
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <Eigen/Dense>
+#include "Impact.hpp"
+
+namespace tca {
+
+struct CVOptions {
+  std::size_t folds = 5;
+  std::size_t gap_blocks = 0;      // blocks on each side of a test fold kept out of training
+  std::vector<double> lambdas{0.0, 1e-4, 1e-3, 1e-2, 1e-1, 1.0};
+  unsigned threads = 1;
+};
+
+// One (control set, ridge penalty) grid point.
+struct CVPoint {
+  bool spread = false;
+  bool sigma = false;
+  double lambda = 0.0;
+  double rmse = 0.0;        // pooled over folds: sqrt(sum SSE / sum n_test), bps
+  double rmse_se = 0.0;     // std. error of the per-fold RMSEs
+  std::size_t failed = 0;   // folds whose training system was singular
+};
+
+struct ImpactCV {
+  std::vector<CVPoint> grid;     // control sets outer, lambdas inner
+  std::size_t best = 0;          // argmin rmse
+  std::size_t blocks = 0;
+  std::size_t folds = 0;
+  ImpactFit fit;                 // selected model refit on every block
+};
+
+// Blocked time-series k-fold CV over the four control sets x the ridge grid.
+// Input is per-block Gram contributions with the full column set
+// [1, signed_pov, spread, sigma] (e.g. daily_impact_stats with both controls),
+// in time order; folds are contiguous runs of blocks. Each fold's train and
+// test systems come from block sums and narrower control sets are
+// sub-matrices, so the grid costs k x k work per point after the one pass
+// that built the blocks. The ridge penalty is lambda * n_train * var_j on
+// each non-intercept column (scale-free); the intercept is not penalized.
+ImpactCV cross_validate_impact(const std::vector<NormalEquations>& blocks, const CVOptions& opt = {});
+
+} // namespace tca
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include "Impact.hpp"
+
+namespace tca {
+
+// The impact.json object, shared by impact.json, the per-symbol table and
+// report.json: eta_bp_per_10pov, gamma_bp_per_10pov and beta; missing keys
+// keep the ImpactParams defaults. Found by nlohmann's ADL, so json(p) and
+// j.get<ImpactParams>() work.
+inline void to_json(nlohmann::json& j, const ImpactParams& p) {
+  j = nlohmann::json{
+    {"eta_bp_per_10pov", p.eta_bp_per_10pov},
+    {"gamma_bp_per_10pov", p.gamma_bp_per_10pov},
+    {"beta", p.beta}
+  };
+}
+
+inline void from_json(const nlohmann::json& j, ImpactParams& p) {
+  const ImpactParams d;
+  p.eta_bp_per_10pov   = j.value("eta_bp_per_10pov", d.eta_bp_per_10pov);
+  p.gamma_bp_per_10pov = j.value("gamma_bp_per_10pov", d.gamma_bp_per_10pov);
+  p.beta               = j.value("beta", d.beta);
+}
+
+} // namespace tca
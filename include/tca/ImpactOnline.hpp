@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <Eigen/Dense>
+#include "Types.hpp"
+#include "Impact.hpp"
+
+namespace tca {
+
+// Recursive least squares on the temporary-impact regression with
+// exponential forgetting. Columns match build_temp_impact_design; storage
+// is fixed-capacity Eigen, so update() never allocates.
+class RlsImpactEstimator {
+public:
+  static constexpr int kMaxK = 4;
+  using Vec = Eigen::Matrix<double, Eigen::Dynamic, 1, 0, kMaxK, 1>;
+  using Mat = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, kMaxK, kMaxK>;
+
+  // forgetting in (0, 1]: effective memory ~ 1 / (1 - forgetting) rows.
+  // delta scales the initial covariance (large = diffuse prior).
+  RlsImpactEstimator(bool include_spread_control = true,
+                     bool include_sigma_control  = true,
+                     double forgetting = 0.999,
+                     double delta = 1e4);
+
+  // Start from an existing fit (e.g. last night's OLS) instead of zeros.
+  void warm_start(const Eigen::VectorXd& coef, double delta);
+
+  // O(k^2) update with one row (k() entries) / one fill against its as-of snap.
+  void update(const double* x, double y);
+  void update(const Fill& f, const Snap& sref);
+
+  ImpactParams params() const;
+  const Vec& coef() const { return w_; }
+  const Mat& covariance() const { return P_; }
+  int k() const { return k_; }
+  std::size_t updates() const { return n_; }
+
+private:
+  bool sp_, sg_;
+  int k_;
+  double lambda_;
+  Vec w_;
+  Mat P_;
+  Vec Px_;
+  std::size_t n_ = 0;
+};
+
+} // namespace tca
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Types.hpp"
+#include "Impact.hpp"
+
+namespace tca {
+
+// Per-symbol impact parameters plus the pooled (random-effects mean) set
+// for symbols that were not calibrated. Symbols are kept sorted and unique
+// for binary-search lookup.
+struct ImpactTable {
+  std::vector<std::string> symbols;
+  std::vector<ImpactParams> params;
+  ImpactParams pooled;
+
+  // nullptr if the symbol is not in the table; the caller decides whether
+  // pooled applies.
+  const ImpactParams* find(const std::string& symbol) const;
+};
+
+void write_impact_table_json(const std::string& path, const ImpactTable& T);
+ImpactTable load_impact_table_json(const std::string& path);
+
+// One symbol of the calibration universe.
+struct UniverseEntry {
+  std::string symbol;
+  std::string fills_path;
+  std::string mkt_path;
+};
+
+// universe.jsonl: one {"symbol", "fills", "mkt"} object per line; a
+// repeated symbol is an error.
+std::vector<UniverseEntry> load_universe_jsonl(const std::string& path);
+
+// Loads each symbol's files and accumulates its temporary-impact normal
+// equations; symbols are spread over `threads` workers.
+std::vector<NormalEquations> panel_impact_stats(const std::vector<UniverseEntry>& universe,
+                                                bool include_spread_control,
+                                                bool include_sigma_control,
+                                                unsigned threads);
+
+struct PanelImpactFit {
+  ImpactTable table;
+  ImpactFit pooled;                 // OLS on the summed normal equations
+  double mu_eta = 0.0;              // random-effects mean of eta (per 10% POV)
+  double tau2 = 0.0;                // between-symbol variance of eta
+  std::vector<double> raw_eta;      // per-symbol OLS eta; NaN if not estimable
+  std::vector<double> se_eta;
+  std::vector<double> shrink;       // weight on mu_eta: se^2 / (se^2 + tau2)
+};
+
+// Pooled fit plus empirical-Bayes shrinkage of each symbol's eta toward the
+// random-effects mean (DerSimonian-Laird estimate of tau^2). Symbols whose
+// own X'X is singular or too small get the mean. Symbols must be unique.
+PanelImpactFit fit_impact_panel(const std::vector<std::string>& symbols,
+                                const std::vector<NormalEquations>& stats);
+
+} // namespace tca
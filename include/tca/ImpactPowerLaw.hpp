@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <Eigen/Dense>
+#include "Impact.hpp"
+
+namespace tca {
+
+// Nonlinear temporary impact:
+//   y = c0 + eta * side * (pov / 0.1)^beta [+ c_spread * spread] [+ c_sigma * sigma]
+// so eta keeps its "bps per 10% POV" meaning for any beta.
+struct PowerLawOptions {
+  bool include_spread_control = true;
+  bool include_sigma_control  = true;
+  int max_iter = 100;
+  double tol = 1e-10;          // relative SSE decrease / step size to stop
+  double beta_min = 0.05;
+  double beta_max = 3.0;
+};
+
+struct PowerLawFit {
+  ImpactParams params;         // eta_bp_per_10pov and beta
+  Eigen::VectorXd theta;       // [c0, eta, beta, controls...]
+  double sse = 0.0;
+  double r2 = 0.0;
+  int iterations = 0;
+  bool converged = false;
+};
+
+// Levenberg-Marquardt with analytic Jacobian. Each trial step is one fused
+// pass over the columns that evaluates residuals, J'J and J'r together;
+// log(pov / 0.1) is precomputed so a pass needs one exp per row. Warm
+// starts from the linear OLS fit (beta = 1).
+PowerLawFit fit_temporary_impact_power_law(const ImpactColumns& C, const PowerLawOptions& opt = {});
+
+} // namespace tca
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+#include "Impact.hpp"
+
+namespace tca {
+
+enum class RobustLoss { Huber, Tukey };
+
+std::string to_string(RobustLoss l);
+
+struct RobustOptions {
+  bool include_spread_control = true;
+  bool include_sigma_control  = true;
+  RobustLoss loss = RobustLoss::Huber;
+  double tuning = 0.0;       // in MAD-scale units; 0 = 1.345 (Huber) / 4.685 (Tukey)
+  int max_iter = 50;
+  double tol = 1e-8;         // max |db| / (|b| + 1) to stop
+  unsigned threads = 1;
+};
+
+struct RobustIteration {
+  double max_step = 0.0;     // max relative coefficient change
+  double objective = 0.0;    // sum of rho(r / scale) at the weights' coefficients
+  double weight_sum = 0.0;
+};
+
+struct RobustFit {
+  ImpactFit fit;             // coef, weighted-Gram se, sigma2, n
+  double scale = 0.0;        // MAD of the OLS residuals / 0.6745, bps
+  double tuning = 0.0;
+  int iterations = 0;
+  bool converged = false;
+  std::size_t downweighted = 0;   // rows with weight < 1 at the solution
+  std::size_t rejected = 0;       // rows with weight 0 (Tukey only)
+  std::vector<RobustIteration> history;
+};
+
+// M-estimation by iteratively reweighted least squares. The scale is fixed
+// at the MAD of the OLS residuals; every iteration is then one fused pass
+// over the columns that computes residuals and weights and folds them into
+// a weighted k x k Gram (deterministic chunked reduction across threads).
+// Tukey's biweight is non-convex, so it starts from the converged Huber fit.
+RobustFit fit_temporary_impact_robust(const ImpactColumns& C, const RobustOptions& opt = {});
+
+} // namespace tca
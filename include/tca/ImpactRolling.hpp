@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include "Types.hpp"
+#include "Impact.hpp"
+
+namespace tca {
+
+// Per-day sufficient statistics of the temporary-impact regression.
+struct DailyImpactStats {
+  std::vector<long long> day;          // floor(time / day_s), ascending
+  std::vector<NormalEquations> ne;     // one entry per day that had fills
+};
+
+// One as-of merge over time-sorted fills, cutting a new NormalEquations at
+// each day boundary.
+DailyImpactStats daily_impact_stats(const Fills& fills,
+                                    const Snaps& snaps,
+                                    double day_s = 86400.0,
+                                    bool include_spread_control = true,
+                                    bool include_sigma_control  = true);
+
+// Sliding window of the last `window` days. Each push adds the newest day's
+// Gram contribution and subtracts the one that falls out, so a step costs
+// O(k^2) however many fills the window holds. Every `resync_every` steps
+// the window sum is rebuilt from the stored days to bound the rounding
+// drift that repeated subtraction accumulates.
+class RollingImpactFitter {
+public:
+  explicit RollingImpactFitter(std::size_t window, std::size_t resync_every = 250);
+
+  void push(const NormalEquations& day);
+  bool full() const { return days_.size() == window_; }
+  const NormalEquations& window_sums() const { return sum_; }
+  ImpactFit fit() const { return solve_normal_equations(sum_); }
+
+private:
+  std::size_t window_;
+  std::size_t resync_every_;
+  std::size_t since_resync_ = 0;
+  std::deque<NormalEquations> days_;
+  NormalEquations sum_;
+};
+
+struct RollingImpactPoint {
+  long long day = 0;     // last day in the window
+  bool ok = false;       // false when the window's X'X was singular
+  ImpactFit fit;
+};
+
+// Fits every `step`-th full window of `window` days.
+std::vector<RollingImpactPoint> rolling_impact_fits(const DailyImpactStats& stats,
+                                                    std::size_t window,
+                                                    std::size_t step = 1);
+
+} // namespace tca
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Impact.hpp"
+
+namespace tca {
+
+// 64-bit FNV-1a, used for model-spec hashes and input fingerprints.
+inline std::uint64_t fnv1a64(const void* data, std::size_t n, std::uint64_t h = 0xcbf29ce484222325ull) {
+  const auto* p = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 0x100000001b3ull; }
+  return h;
+}
+
+// Content fingerprint of the fit inputs: FNV-1a over the bytes of each file in order.
+std::uint64_t fingerprint_files(const std::vector<std::string>& paths);
+
+// Canonical spec string / hash of the temporary-impact OLS model.
+std::string temp_impact_spec(bool include_spread_control, bool include_sigma_control);
+std::uint64_t spec_hash(const std::string& spec);
+// The temp_impact_spec string whose hash is h, or "" if h is not one.
+std::string temp_impact_spec_name(std::uint64_t h);
+
+// Fixed 128-byte record. Records are kept sorted by
+// (symbol, spec_hash, window_end, window_start), which is the lookup key;
+// input_fp says which input bytes produced the parameters.
+struct ImpactRecord {
+  char symbol[32] = {};
+  std::uint64_t spec_hash = 0;
+  std::uint64_t input_fp = 0;
+  double window_start = 0.0;
+  double window_end = 0.0;
+  double eta_bp_per_10pov = 0.0;
+  double gamma_bp_per_10pov = 0.0;
+  double beta = 1.0;
+  std::uint64_t n = 0;
+  double r2 = 0.0;
+  std::uint64_t reserved[3] = {};
+
+  ImpactParams params() const;
+};
+static_assert(sizeof(ImpactRecord) == 128, "ImpactRecord layout is part of the file format");
+
+ImpactRecord make_impact_record(const std::string& symbol, std::uint64_t spec, std::uint64_t input_fp,
+                                double window_start, double window_end, const ImpactFit& fit);
+
+// Read-only, memory-mapped view of a store file. Lookups binary-search the
+// mapped records directly; nothing is parsed or copied on open. A missing
+// file opens as an empty store.
+class ImpactStoreView {
+public:
+  explicit ImpactStoreView(const std::string& path);
+  ~ImpactStoreView();
+  ImpactStoreView(const ImpactStoreView&) = delete;
+  ImpactStoreView& operator=(const ImpactStoreView&) = delete;
+
+  std::size_t size() const { return count_; }
+  const ImpactRecord* begin() const { return recs_; }
+  const ImpactRecord* end() const { return recs_ + count_; }
+
+  // Exact key match, or nullptr.
+  const ImpactRecord* find(const std::string& symbol, std::uint64_t spec,
+                           double window_start, double window_end) const;
+  // Latest record for (symbol, spec) fitted from inputs with fingerprint fp.
+  const ImpactRecord* find_input(const std::string& symbol, std::uint64_t spec, std::uint64_t fp) const;
+  // Record with the latest window_end for the symbol; spec == 0 matches any spec.
+  const ImpactRecord* latest(const std::string& symbol, std::uint64_t spec = 0) const;
+
+private:
+  std::pair<const ImpactRecord*, const ImpactRecord*> symbol_range(const std::string& symbol) const;
+
+  void* map_ = nullptr;
+  std::size_t bytes_ = 0;
+  const ImpactRecord* recs_ = nullptr;
+  std::size_t count_ = 0;
+};
+
+// Insert or replace the record with the same key. Writers hold an exclusive
+// flock on path + ".lock" for the read-modify-write; the file is rewritten
+// to a unique temporary, fsynced and renamed over the original, so readers
+// holding a mapping keep a consistent snapshot.
+void upsert_impact_store(const std::string& path, const ImpactRecord& rec);
+
+} // namespace tca
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+#include "Types.hpp"
+#include "Impact.hpp"
+
+namespace tca {
+
+// Sufficient statistics for the temporary-impact regression with one
+// intercept per venue: y = a_venue + b'x + e, where x is the usual row
+// without its intercept column (signed POV, then the enabled controls).
+// Besides the pooled Gram of x we keep only (n, sum x, sum y) per venue,
+// so memory is O(k^2 + V*k) and no V-wide dummy block is ever formed.
+struct VenueImpactStats {
+  std::vector<std::string> venues;     // first-seen order
+  std::vector<std::size_t> n;          // fills per venue
+  Eigen::MatrixXd sx;                  // (k-1) x V, per-venue column sums of x
+  Eigen::VectorXd sy;                  // V, per-venue sums of y
+  NormalEquations ne;                  // pooled Gram of x (no intercept)
+};
+
+VenueImpactStats accumulate_venue_impact(const Fills& fills,
+                                         const Snaps& snaps,
+                                         bool include_spread_control = true,
+                                         bool include_sigma_control  = true);
+
+struct VenueIntercept {
+  std::string venue;
+  std::size_t n = 0;
+  double alpha = 0.0;     // bps, venue fixed effect
+  double se = 0.0;
+};
+
+struct VenueImpactFit {
+  ImpactParams params;
+  Eigen::VectorXd coef;   // slopes on [signed_pov, controls...]
+  Eigen::VectorXd se;
+  double sigma2 = 0.0;    // SSE / (n - V - (k-1))
+  double r2_within = 0.0;
+  std::size_t n = 0;
+  std::vector<int> aliased;             // slopes dropped as combinations of earlier ones
+  std::vector<VenueIntercept> venues;   // sorted by venue name
+};
+
+// Within (fixed-effects) estimator solved from the stats: demeaning by venue
+// turns the pooled Gram into X'X - sum_v sx_v sx_v' / n_v, a (k-1)x(k-1)
+// system; intercepts are recovered as mean(y_v) - mean(x_v)'b.
+VenueImpactFit fit_venue_impact(const VenueImpactStats& stats);
+
+} // namespace tca
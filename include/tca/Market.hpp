@@ -1,5 +1,6 @@
 #pragma once
 #include <algorithm>
+#include <cstddef>
 #include "Types.hpp"
 
 namespace tca {
@@ -12,4 +13,33 @@ inline double mid_at_or_before(const Snaps& M, double t) {
   return std::prev(it)->mid;
 }
 
+// Same as-of rule as mid_at_or_before, but amortized O(1) for time-sorted
+// queries: the cursor walks forward and only binary-searches on a rewind.
+class AsOfCursor {
+public:
+  explicit AsOfCursor(const Snaps& M) : M_(&M) {}
+
+  const Snap& at(double t) {
+    const Snaps& M = *M_;
+    if (j_ > 0 && M[j_].time > t) seek(t);
+    while (j_ + 1 < M.size() && M[j_ + 1].time <= t) ++j_;
+    return M[j_];
+  }
+
+  // Binary-search reposition; use before the first at() when starting
+  // somewhere other than the beginning of the day.
+  void seek(double t) {
+    const Snaps& M = *M_;
+    auto it = std::upper_bound(M.begin(), M.end(), t,
+      [](double tt, const Snap& s){ return tt < s.time; });
+    j_ = (it == M.begin()) ? 0 : static_cast<std::size_t>(std::prev(it) - M.begin());
+  }
+
+  std::size_t index() const { return j_; }
+
+private:
+  const Snaps* M_;
+  std::size_t j_ = 0;
+};
+
 } // namespace tca
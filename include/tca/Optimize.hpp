@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <cstddef>
+#include <span>
 #include "Types.hpp"
 #include "Impact.hpp"
 
@@ -12,13 +13,74 @@ namespace tca {
         double horizon_s = 0.0;
         int slices = 1;
         double max_pov = 0.0;
-        double risk_lambda = 0.0;
+        double min_pov = 0.0;       // participation floor per slice (ScheduleQP)
+        double risk_lambda = 0.0;   // Almgren-Chriss risk aversion, per bps of cost
     };
 
     struct Schedule {
         std::vector<double> x;
+        bool feasible = true;      // false when the caps cannot absorb the order
+        double shortfall = 0.0;    // unfilled shares when infeasible
     };
 
+    enum class ProjectionStatus { Ok, Infeasible };
+
+    // Exact Euclidean projection of y (in x, overwritten) onto
+    // {0 <= x_i <= caps_i, sum x = Q}: x_i = clamp(y_i - theta, 0, caps_i)
+    // with theta found by sorting the 2n breakpoints and sweeping the
+    // piecewise-linear sum, O(n log n). scratch must hold 2n doubles; nothing
+    // is allocated. If Q exceeds sum(caps), x is set to caps and Infeasible
+    // is returned.
+    ProjectionStatus project_capped_simplex(std::span<double> x,
+                                            std::span<const double> caps,
+                                            double Q,
+                                            std::span<double> scratch);
+
+    // Slice length: horizon_s / slices, or the forecast's time step when no
+    // horizon is given (1 s if that is unusable too).
+    double slice_seconds(const OrderSpec& spec, const Snaps& forecast);
+
+    // POV cap of one slice in shares: max_pov * vol_est, 0 if either is <= 0.
+    double cap_for_slice(double max_pov, double vol_est);
+
+    // Annualized sigma -> bps per sqrt(second) over 252 sessions of 6.5 hours.
+    double sigma_bps_per_sqrt_s(double sigma_annual);
+
+    // Expected cost and variance of a schedule, in bps of the order's
+    // notional, under the discrete Almgren-Chriss model: temporary impact
+    // eta * (pov / 10%) per slice, permanent gamma * (pov / 10%) carried by
+    // the remaining holdings, half the spread per share, and price variance
+    // from each slice's sigma (annualized, 252 x 6.5h sessions) on what is
+    // still held. The model is linear in POV: ImpactParams::beta is not used
+    // here, by almgren_chriss_schedule or by the schedule QP.
+    struct ScheduleCost {
+        double expected_cost_bps = 0.0;
+        double variance_bps2 = 0.0;
+    };
+
+    ScheduleCost evaluate_schedule(const OrderSpec& spec, const Snaps& forecast,
+                                   const ImpactParams& impact, const Schedule& schedule);
+
+    struct ACSolution {
+        Schedule schedule;
+        double kappa = 0.0;            // urgency, 1/s; 0 means linear (TWAP) decay
+        ScheduleCost cost;             // of the capped schedule
+    };
+
+    // Closed-form Almgren-Chriss trajectory x_j = X sinh(kappa (T - t_j)) / sinh(kappa T)
+    // for the order's horizon and slice count, with eta/gamma scaled by the
+    // order's participation of the mean forecast volume and sigma the mean
+    // forecast sigma; risk_lambda is the risk aversion in 1/bps. O(n), then
+    // projected onto the POV caps.
+    ACSolution almgren_chriss_schedule(const OrderSpec& spec, const Snaps& forecast, const ImpactParams& impact);
+
+    // True when the POV bounds bind on an Almgren-Chriss solution: a floor is
+    // set, the caps cannot absorb the order, or a slice with volume sits at
+    // its cap. The projected closed form is then not optimal.
+    bool pov_bounds_bind(const OrderSpec& spec, const Snaps& forecast, const ACSolution& ac);
+
+    // Almgren-Chriss when neither floors nor caps bind; otherwise the
+    // projected closed form is not optimal and optimize_schedule_qp is used.
     Schedule optimize_schedule(const OrderSpec& spec, const Snaps& forecast, const ImpactParams& impact);
 
     Schedule twap_schedule(const OrderSpec& spec, const Snaps& forecast);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "Types.hpp"
+#include "Impact.hpp"
+#include "Optimize.hpp"
+#include "ScheduleQP.hpp"
+
+namespace tca {
+
+// order.json keys: side ("BUY"/"SELL", default BUY), qty, slices,
+// horizon_s, max_pov (1.0), min_pov, risk_lambda (0.0). Throws on a
+// missing or mistyped required key and on slices <= 0.
+OrderSpec order_spec_from_json(const nlohmann::json& j);
+
+struct BatchOrder {
+  std::string id;       // "id" field, else the 0-based order index
+  std::string symbol;
+  OrderSpec spec;
+  double start_ts;      // "start_ts" in forecast time; NaN = the forecast's first row
+  std::string error;    // why the line could not be read; empty if fine
+};
+
+// orders.jsonl: one order.json object per line plus "symbol" (and optional
+// "id" and "start_ts"). A malformed line is kept with its error set (prefixed
+// path:line) so it fails alone in optimize_batch.
+std::vector<BatchOrder> load_orders_jsonl(const std::string& path);
+
+// Per-symbol inputs shared by all orders, indexed alike; symbols is
+// sorted. Orders of a symbol with an error (or an empty forecast) fail.
+struct BatchMarket {
+  std::vector<std::string> symbols;
+  std::vector<Snaps> forecasts;
+  std::vector<ImpactParams> impact;
+  std::vector<std::string> error;   // why the symbol is unusable; empty if fine
+
+  // Index into symbols, or symbols.size() if absent.
+  std::size_t find(const std::string& symbol) const;
+};
+
+// Collects the symbols of orders without an error and loads each forecast from
+// <mkt_dir>/<symbol>.csv in parallel. A missing or unreadable file sets
+// the symbol's error. Impact parameters are left default for the caller.
+BatchMarket load_batch_forecasts(const std::vector<BatchOrder>& orders,
+                                 const std::string& mkt_dir,
+                                 unsigned threads);
+
+// Maps the forecast rows covering [t0, t1) onto `slices` equal buckets
+// (row r spans [time_r, time_r+1), the last row one step; fractional
+// overlap at the edges): volume is split in proportion, spread and sigma
+// are overlap-weighted means, mid comes from the bucket's first row and
+// time is the bucket start; t1 = +inf runs to the end of the forecast.
+// Throws if the window is empty or leaves the forecast's span. Copies the forecast when the window is the whole span
+// and the row count already matches; `out` is reused as a buffer.
+void resample_forecast(const Snaps& forecast, double t0, double t1, int slices, Snaps& out);
+
+struct BatchOptions {
+  unsigned threads = 0;
+  std::size_t grain = 8;       // orders per work-stealing chunk
+  bool qp = false;             // always the QP; else Almgren-Chriss unless POV bounds bind
+  ScheduleQPOptions qp_opt;
+};
+
+struct BatchSummary {
+  std::size_t orders = 0;
+  std::size_t written = 0;     // orders with a schedule in the output
+  std::size_t failed = 0;      // bad line, unknown symbol, no forecast or bad spec
+  std::size_t infeasible = 0;  // POV caps/floors cannot be met (schedule written)
+  std::size_t rows = 0;
+};
+
+// Schedules every order on a work-stealing pool (per-worker QP workspace
+// and forecast buffer) and streams `order,symbol,slice,shares` rows to
+// out in input order: finished chunks are formatted by their worker and
+// flushed as soon as every earlier order is out. Per-order failures are
+// reported on `errors` and skipped.
+BatchSummary optimize_batch(const std::vector<BatchOrder>& orders,
+                            const BatchMarket& market,
+                            const BatchOptions& opt,
+                            std::ostream& out,
+                            std::ostream& errors);
+
+} // namespace tca
@@ -0,0 +1,119 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace tca {
+
+// 0 means "use every hardware thread".
+inline unsigned resolve_threads(unsigned requested) {
+  if (requested > 0) return requested;
+  const unsigned hw = std::thread::hardware_concurrency();
+  return hw > 0 ? hw : 1;
+}
+
+// Calls fn(begin, end) on contiguous, near-equal slices of [0, n), one slice
+// per worker; the calling thread takes the first slice. The first exception
+// thrown by any worker is rethrown after all workers have joined.
+template <class Fn>
+void parallel_for(std::size_t n, unsigned threads, Fn&& fn) {
+  if (n == 0) return;
+  const std::size_t T = std::min<std::size_t>(resolve_threads(threads), n);
+  if (T == 1) { fn(std::size_t{0}, n); return; }
+
+  std::exception_ptr err;
+  std::mutex err_mu;
+  auto run = [&](std::size_t t) {
+    const std::size_t b = n * t / T, e = n * (t + 1) / T;
+    try { fn(b, e); }
+    catch (...) { std::lock_guard<std::mutex> lk(err_mu); if (!err) err = std::current_exception(); }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(T - 1);
+  for (std::size_t t = 1; t < T; ++t) pool.emplace_back(run, t);
+  run(0);
+  for (auto& th : pool) th.join();
+  if (err) std::rethrow_exception(err);
+}
+
+// Work-stealing variant for uneven per-item cost. Each worker owns a
+// contiguous share of [0, n) and takes `grain` items at a time from its
+// front; once empty it steals the back half of another worker's remaining
+// range. Ranges stay contiguous, so items are finished roughly in index
+// order. fn(worker, begin, end) gets the worker index in [0, workers) for
+// per-thread scratch; the calling thread is worker 0. Exceptions as in
+// parallel_for; after the first one no new chunks are started.
+template <class Fn>
+void parallel_for_stealing(std::size_t n, unsigned threads, std::size_t grain, Fn&& fn) {
+  if (n == 0) return;
+  if (n > 0xffffffffu) throw std::invalid_argument("parallel_for_stealing: n must fit in 32 bits");
+  const std::size_t T = std::min<std::size_t>(resolve_threads(threads), n);
+  grain = std::max<std::size_t>(grain, 1);
+  if (T == 1) {
+    for (std::size_t b = 0; b < n; b += grain) fn(0u, b, std::min(n, b + grain));
+    return;
+  }
+
+  // [begin, end) packed into one word so owner pops and thief splits are
+  // single CAS operations. A drained range is only refilled by its owner.
+  struct alignas(64) Range { std::atomic<std::uint64_t> r; };
+  auto pack = [](std::uint64_t b, std::uint64_t e) { return (b << 32) | e; };
+  std::unique_ptr<Range[]> ranges(new Range[T]);
+  for (std::size_t t = 0; t < T; ++t) ranges[t].r.store(pack(n * t / T, n * (t + 1) / T));
+
+  std::atomic<bool> stop{false};
+  std::exception_ptr err;
+  std::mutex err_mu;
+  auto run = [&](std::size_t t) {
+    auto& mine = ranges[t].r;
+    try {
+      while (!stop.load(std::memory_order_relaxed)) {
+        std::uint64_t cur = mine.load();
+        std::uint64_t b = cur >> 32, e = cur & 0xffffffffu;
+        if (b < e) {
+          const std::uint64_t stop_at = std::min<std::uint64_t>(e, b + grain);
+          if (!mine.compare_exchange_weak(cur, pack(stop_at, e))) continue;
+          fn(static_cast<unsigned>(t), static_cast<std::size_t>(b), static_cast<std::size_t>(stop_at));
+          continue;
+        }
+        bool stole = false;
+        for (std::size_t k = 1; k < T && !stole; ++k) {
+          auto& victim = ranges[(t + k) % T].r;
+          std::uint64_t v = victim.load();
+          while (true) {
+            const std::uint64_t vb = v >> 32, ve = v & 0xffffffffu;
+            if (ve <= vb) break;
+            const std::uint64_t mid = ve - (ve - vb + 1) / 2;   // thief takes [mid, ve)
+            if (victim.compare_exchange_weak(v, pack(vb, mid))) {
+              mine.store(pack(mid, ve));
+              stole = true;
+              break;
+            }
+          }
+        }
+        if (!stole) break;
+      }
+    } catch (...) {
+      stop.store(true);
+      std::lock_guard<std::mutex> lk(err_mu);
+      if (!err) err = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(T - 1);
+  for (std::size_t t = 1; t < T; ++t) pool.emplace_back(run, t);
+  run(0);
+  for (auto& th : pool) th.join();
+  if (err) std::rethrow_exception(err);
+}
+
+} // namespace tca
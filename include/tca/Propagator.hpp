@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Types.hpp"
+#include "Optimize.hpp"
+
+namespace tca {
+
+// Transient (propagator) impact: on a uniform grid of dt seconds,
+//   I_t = kappa * sum_{s <= t} G((t - s) * dt) * u_s      [bps]
+// where u_s is the signed participation traded in slice s.
+enum class KernelKind { Exponential, PowerLaw };
+
+struct PropagatorKernel {
+  KernelKind kind = KernelKind::Exponential;
+  double tau_s = 300.0;   // exponential: G(l) = exp(-l / tau)
+  double beta = 0.5;      // power law:   G(l) = (1 + l / l0)^-beta
+  double l0_s = 1.0;
+
+  double at(double lag_s) const;
+};
+
+struct PropagatorModel {
+  PropagatorKernel kernel;
+  double kappa = 0.0;     // bps per unit participation at lag 0
+};
+
+std::string to_string(KernelKind k);
+
+// Forward evaluator. The exponential kernel uses the O(n) recursion
+// I_t = exp(-dt/tau) I_{t-1} + kappa u_t; the power law uses a zero-padded
+// radix-2 FFT convolution, O(n log n) (direct sum for short series).
+std::vector<double> propagate(const PropagatorModel& m, const std::vector<double>& u, double dt_s);
+
+// Slice series for calibration: u_t = sum side * qty / as-of snap volume
+// over the fills in slice t, dmid_bps_t = mid move across the slice.
+struct PropagatorSeries {
+  double dt_s = 1.0;
+  double t0 = 0.0;
+  std::vector<double> u;
+  std::vector<double> dmid_bps;
+};
+
+PropagatorSeries build_propagator_series(const Fills& fills, const Snaps& snaps, double dt_s);
+
+struct PropagatorGridPoint {
+  PropagatorKernel kernel;
+  double kappa = 0.0;
+  double r2 = 0.0;
+};
+
+struct PropagatorFit {
+  PropagatorModel model;
+  double r2 = 0.0;
+  std::size_t n = 0;
+  std::vector<PropagatorGridPoint> grid;
+};
+
+// Exponential taus and power-law betas spanning the usual decay range.
+std::vector<PropagatorKernel> default_kernel_grid(double dt_s, bool exponential = true, bool power_law = true);
+
+// For each kernel shape, evaluate the unit-kappa propagator once and fit
+// kappa by no-intercept least squares of slice mid moves on its increments;
+// keep the best uncentered R^2 (lowest SSE). Grid points run in parallel.
+PropagatorFit calibrate_propagator(const PropagatorSeries& s,
+                                   const std::vector<PropagatorKernel>& grid,
+                                   unsigned threads = 1);
+
+struct PropagatorCost {
+  std::vector<double> impact_bps;   // transient impact in each slice
+  double cost_bps = 0.0;            // quantity-weighted, positive = cost
+};
+
+// Expected transient-impact cost of a schedule on the forecast grid
+// (dt = slice_seconds, participation x_j / forecast[j].volume). This only
+// evaluates a given schedule; no optimizer minimizes it.
+PropagatorCost propagator_cost(const PropagatorModel& m,
+                               const OrderSpec& spec,
+                               const Snaps& forecast,
+                               const Schedule& schedule);
+
+void write_propagator_json(const std::string& path, const PropagatorModel& m);
+PropagatorModel load_propagator_json(const std::string& path);
+
+} // namespace tca
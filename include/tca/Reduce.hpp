@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "Parallel.hpp"
+
+namespace tca {
+
+// Deterministic reductions.
+//
+// Floating-point addition is not associative, so a parallel sum is only
+// reproducible if the grouping of terms is fixed. Here the grouping depends
+// on n alone: [0, n) is cut into at most max_chunks contiguous chunks of at
+// least min_chunk rows, each chunk is reduced serially in row order, and
+// the chunk partials are combined by a fixed pairwise tree. Threads only
+// decide *who* evaluates a chunk, never how terms are grouped, so results
+// are bit-identical for 1 or 64 threads.
+
+constexpr std::size_t kReduceMinChunk  = 4096;
+constexpr std::size_t kReduceMaxChunks = 256;
+
+struct ChunkPlan {
+  std::size_t n = 0;
+  std::size_t chunks = 0;
+  std::size_t size = 0;
+
+  std::size_t begin(std::size_t c) const { return std::min(n, c * size); }
+  std::size_t end(std::size_t c) const   { return std::min(n, (c + 1) * size); }
+};
+
+inline ChunkPlan plan_chunks(std::size_t n,
+                             std::size_t min_chunk = kReduceMinChunk,
+                             std::size_t max_chunks = kReduceMaxChunks) {
+  ChunkPlan p;
+  p.n = n;
+  if (n == 0) return p;
+  const std::size_t by_cap = (n + max_chunks - 1) / max_chunks;
+  p.size = std::max(min_chunk, by_cap);
+  p.chunks = (n + p.size - 1) / p.size;
+  return p;
+}
+
+// Pairwise combine of parts[lo, hi) with a split point that depends only on
+// the range, consuming the parts.
+template <class T, class Combine>
+T pairwise_combine(std::vector<T>& parts, std::size_t lo, std::size_t hi, Combine& combine) {
+  if (hi - lo == 1) return std::move(parts[lo]);
+  const std::size_t mid = lo + (hi - lo) / 2;
+  T left = pairwise_combine(parts, lo, mid, combine);
+  T right = pairwise_combine(parts, mid, hi, combine);
+  return combine(std::move(left), std::move(right));
+}
+
+// chunk_fn(begin, end) -> T reduces one chunk serially;
+// combine(T, T) -> T merges two adjacent partials (left first).
+template <class T, class ChunkFn, class Combine>
+T deterministic_reduce(const ChunkPlan& plan, unsigned threads, T identity,
+                       ChunkFn&& chunk_fn, Combine&& combine) {
+  if (plan.chunks == 0) return identity;
+  std::vector<T> parts(plan.chunks, identity);
+  parallel_for(plan.chunks, threads, [&](std::size_t b, std::size_t e) {
+    for (std::size_t c = b; c < e; ++c) parts[c] = chunk_fn(plan.begin(c), plan.end(c));
+  });
+  return pairwise_combine(parts, 0, parts.size(), combine);
+}
+
+template <class T, class ChunkFn, class Combine>
+T deterministic_reduce(std::size_t n, unsigned threads, T identity,
+                       ChunkFn&& chunk_fn, Combine&& combine) {
+  return deterministic_reduce(plan_chunks(n), threads, std::move(identity),
+                              std::forward<ChunkFn>(chunk_fn), std::forward<Combine>(combine));
+}
+
+} // namespace tca
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <Eigen/Dense>
+#include "Types.hpp"
+#include "Market.hpp"
+#include "Impact.hpp"
+
+namespace tca {
+
+// Compile-time column sets for the temporary-impact regression. Each tag
+// maps (fill, as-of snap, side sign) to one regressor value; a
+// Regressors<...> list fixes K so rows, X'X and the solve are fixed-size
+// Eigen types and row construction unrolls.
+namespace reg {
+  struct Intercept { static double value(const Fill&, const Snap&, double)   { return 1.0; } };
+  struct SignedPOV { static double value(const Fill& f, const Snap& s, double sg) { return sg * pov(f.qty, s.volume); } };
+  struct Spread    { static double value(const Fill&, const Snap& s, double)  { return s.spread_bps; } };
+  struct Sigma     { static double value(const Fill&, const Snap& s, double)  { return s.sigma; } };
+}
+
+template <class... Cols>
+struct Regressors {
+  static constexpr int K = static_cast<int>(sizeof...(Cols));
+  using Vec = Eigen::Matrix<double, K, 1>;
+  using Mat = Eigen::Matrix<double, K, K>;
+
+  static Vec row(const Fill& f, const Snap& s, double sg) {
+    Vec x;
+    int c = 0;
+    ((x(c++) = Cols::value(f, s, sg)), ...);
+    return x;
+  }
+};
+
+template <class R>
+struct TypedNormalEquations {
+  typename R::Mat XtX = R::Mat::Zero();
+  typename R::Vec Xty = R::Vec::Zero();
+  double yty = 0.0;
+  std::size_t n = 0;
+
+  void add(const typename R::Vec& x, double y) {
+    XtX.noalias() += x * x.transpose();
+    Xty += y * x;
+    yty += y * y;
+    ++n;
+  }
+};
+
+template <class R>
+TypedNormalEquations<R> accumulate_temp_impact_typed(const Fills& fills, const Snaps& snaps) {
+  TypedNormalEquations<R> ne;
+  AsOfCursor cur(snaps);
+  for (const auto& f : fills) {
+    const Snap& s = cur.at(f.time);
+    const double sg = (f.side == Side::BUY) ? +1.0 : -1.0;
+    ne.add(R::row(f, s, sg), sg * (f.px - s.mid) / s.mid * 1e4);
+  }
+  return ne;
+}
+
+// Fixed-size counterpart of solve_normal_equations; column 0 must be
+// reg::Intercept and column 1 reg::SignedPOV.
+template <class R>
+ImpactFit solve_typed(const TypedNormalEquations<R>& ne) {
+  constexpr int K = R::K;
+  static_assert(K >= 2, "need at least intercept and POV");
+  if (ne.n <= static_cast<std::size_t>(K))
+    throw std::invalid_argument("normal equations: need n > k >= 2");
+
+  const Eigen::LDLT<typename R::Mat> ldlt(ne.XtX);
+  if (ldlt.info() != Eigen::Success || !ldlt.isPositive() || ldlt.vectorD().minCoeff() <= 0.0) {
+    // Rank-deficient (e.g. a constant control): the dynamic path drops the
+    // aliased columns.
+    NormalEquations dyn(K);
+    dyn.XtX = ne.XtX; dyn.Xty = ne.Xty; dyn.yty = ne.yty; dyn.n = ne.n;
+    return solve_normal_equations(dyn);
+  }
+
+  const typename R::Vec b = ldlt.solve(ne.Xty);
+  const typename R::Mat inv = ldlt.solve(R::Mat::Identity());
+  ImpactFit fit;
+  ols_diagnostics(ne.XtX, ne.Xty, ne.yty, ne.n, b, inv.diagonal(), K, fit);
+  return fit;
+}
+
+// The four column sets the CLI can ask for.
+using RegFull     = Regressors<reg::Intercept, reg::SignedPOV, reg::Spread, reg::Sigma>;
+using RegSpread   = Regressors<reg::Intercept, reg::SignedPOV, reg::Spread>;
+using RegSigma    = Regressors<reg::Intercept, reg::SignedPOV, reg::Sigma>;
+using RegPOVOnly  = Regressors<reg::Intercept, reg::SignedPOV>;
+
+// Runtime dispatch from the --no-spread / --no-sigma flags to the matching
+// specialization.
+ImpactFit fit_temporary_impact_typed(const Fills& fills,
+                                     const Snaps& snaps,
+                                     bool include_spread_control,
+                                     bool include_sigma_control);
+
+} // namespace tca
@@ -2,6 +2,7 @@
 #include <string>
 #include "Types.hpp"
 #include "IS.hpp"
+#include "Attribution.hpp"
 #include "Impact.hpp"
 #include "Optimize.hpp"
 
@@ -14,17 +15,28 @@ struct TCAReport {
 
   // core results
   ISBreakdown is{};
+  BenchmarkIS benchmarks{};
   ImpactParams impact{};
   Schedule schedule{};
+
+  // optional: filled in when the caller asked for a breakdown by dimension
+  ISAttribution attribution{};
 };
 
 // Write JSON report to path (pretty by default)
 void write_report_json(const std::string& path, const TCAReport& R, bool pretty=true);
 
+// Write impact.json (same keys load_impact_json reads)
+void write_impact_json(const std::string& path, const ImpactParams& p);
+
 // Write schedule CSV: "slice,shares"
 void write_schedule_csv(const std::string& path, const Schedule& sch);
 
 // Write IS breakdown CSV: "metric,value_bps"
 void write_is_csv(const std::string& path, const ISBreakdown& b);
 
+// Write attribution CSV, one row per non-empty cell:
+// "venue,time_bucket,bucket_start,size_bucket,side,fills,qty,notional,<ISBreakdown fields>"
+void write_attribution_csv(const std::string& path, const ISAttribution& A);
+
 } // namespace tca
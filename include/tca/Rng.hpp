@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace tca {
+
+inline std::uint64_t splitmix64(std::uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+// Counter-based draw: a pure function of (seed, stream, counter), so any
+// replicate can be regenerated on any thread in any order.
+inline std::uint64_t counter_draw(std::uint64_t seed, std::uint64_t stream, std::uint64_t counter) {
+  return splitmix64(splitmix64(seed ^ splitmix64(stream)) + counter);
+}
+
+// Map a 64-bit draw to [0, n) using its top 53 bits.
+inline std::size_t draw_index(std::uint64_t r, std::size_t n) {
+  const double u = static_cast<double>(r >> 11) * 0x1.0p-53;
+  const std::size_t i = static_cast<std::size_t>(u * static_cast<double>(n));
+  return i < n ? i : n - 1;
+}
+
+} // namespace tca
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "Types.hpp"
+#include "Impact.hpp"
+#include "Optimize.hpp"
+
+namespace tca {
+
+struct ScheduleQPOptions {
+  double eps_abs = 1e-9;     // on order fractions
+  double eps_rel = 1e-7;
+  int max_iter = 5000;
+  double rho = 0.0;          // ADMM penalty; 0 = mean temporary-impact curvature
+  bool adaptive_rho = true;  // residual balancing every 25 iterations (O(n) refactor)
+  bool polish = true;        // exact solve on the active set guessed by ADMM
+};
+
+// Iterates and factorization kept between solves. A workspace reused for
+// an order with the same slice count warm-starts from the previous
+// solution and penalty.
+struct ScheduleQPWorkspace {
+  std::vector<double> h;        // holdings after slices 0..n-2, fractions
+  std::vector<double> z, u;     // per-slice trades (box copy) and scaled dual
+  std::vector<double> a, b, c;  // quadratic trade, risk and linear trade weights
+  std::vector<double> lo, hi;   // per-slice trade bounds, fractions
+  std::vector<double> l, m;     // tridiagonal LDL' factor
+  std::vector<double> rhs, tmp, scratch;
+  std::vector<int> at;          // polish: active bound per slice
+  std::vector<std::size_t> grp; // polish: bound-merged groups of slices
+  std::vector<double> off, pd, po, pr;
+  double rho = 0.0;
+  bool warm = false;
+};
+
+struct ScheduleQPResult {
+  Schedule schedule;
+  ScheduleCost cost;
+  int iterations = 0;
+  bool converged = false;
+  bool polished = false;     // converged by the active-set solve
+  double primal_residual = 0.0;
+  double dual_residual = 0.0;
+};
+
+// Almgren-Chriss cost (as in evaluate_schedule) plus risk_lambda * variance,
+// minimized over the whole schedule subject to
+//   min_pov * V_j <= x_j <= max_pov * V_j,  sum x_j = qty.
+// Solved by ADMM in holdings space: completion is built into the variables,
+// the x-update is one tridiagonal (Thomas) solve, O(n), and the z-update
+// clamps each slice's trade to its POV box. Every 10 iterations the bounds
+// the iterate sits on are tried as the active set (one more tridiagonal
+// solve plus a KKT check), which usually ends the solve long before the
+// residual tolerances are met. The final iterate is projected exactly
+// onto the constraint set. If the caps cannot absorb the order the caps
+// are returned (shortfall > 0); if the floors alone exceed it they are
+// scaled down to the order (shortfall 0). Both are flagged infeasible.
+ScheduleQPResult optimize_schedule_qp(const OrderSpec& spec,
+                                      const Snaps& forecast,
+                                      const ImpactParams& impact,
+                                      const ScheduleQPOptions& opt,
+                                      ScheduleQPWorkspace& ws);
+
+ScheduleQPResult optimize_schedule_qp(const OrderSpec& spec,
+                                      const Snaps& forecast,
+                                      const ImpactParams& impact,
+                                      const ScheduleQPOptions& opt = {});
+
+} // namespace tca
@@ -0,0 +1,197 @@
+#include "../include/tca/Attribution.hpp"
+#include "../include/tca/Market.hpp"
+#include "../include/tca/Reduce.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace tca {
+
+static int intern_venue(std::vector<std::string>& names, const std::string& v, int& last) {
+  // Fills from the same venue tend to arrive in runs; check the last hit first.
+  if (last >= 0 && names[static_cast<std::size_t>(last)] == v) return last;
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    if (names[i] == v) { last = static_cast<int>(i); return last; }
+  }
+  names.push_back(v);
+  last = static_cast<int>(names.size() - 1);
+  return last;
+}
+
+namespace {
+
+// Sparse partial table: the non-empty cells of one chunk (or of a merged run
+// of chunks), ascending by cell index.
+struct AttrPart {
+  std::vector<std::size_t> idx;
+  std::vector<ISSums> sums;
+  std::vector<std::size_t> counts;
+  ISSums total;
+};
+
+void add_sums(ISSums& a, const ISSums& b) {
+  a.qty += b.qty; a.paid += b.paid; a.spread += b.spread; a.fees += b.fees;
+}
+
+// Merges two partials, left first; cells present in both are added.
+AttrPart merge_parts(const AttrPart& a, const AttrPart& b) {
+  AttrPart out;
+  out.idx.reserve(a.idx.size() + b.idx.size());
+  out.sums.reserve(a.idx.size() + b.idx.size());
+  out.counts.reserve(a.idx.size() + b.idx.size());
+  std::size_t i = 0, j = 0;
+  while (i < a.idx.size() || j < b.idx.size()) {
+    if (j == b.idx.size() || (i < a.idx.size() && a.idx[i] < b.idx[j])) {
+      out.idx.push_back(a.idx[i]); out.sums.push_back(a.sums[i]); out.counts.push_back(a.counts[i]); ++i;
+    } else if (i == a.idx.size() || b.idx[j] < a.idx[i]) {
+      out.idx.push_back(b.idx[j]); out.sums.push_back(b.sums[j]); out.counts.push_back(b.counts[j]); ++j;
+    } else {
+      ISSums c = a.sums[i];
+      add_sums(c, b.sums[j]);
+      out.idx.push_back(a.idx[i]); out.sums.push_back(c); out.counts.push_back(a.counts[i] + b.counts[j]);
+      ++i; ++j;
+    }
+  }
+  out.total = a.total;
+  add_sums(out.total, b.total);
+  return out;
+}
+
+// Per-worker scratch, reused across that worker's chunks: maps a cell index
+// to its slot in the chunk being accumulated.
+struct AttrScratch {
+  std::unordered_map<std::size_t, std::size_t> slot;
+  std::vector<std::size_t> idx;
+  std::vector<ISSums> sums;
+  std::vector<std::size_t> counts;
+  std::vector<std::size_t> order;
+
+  std::size_t at(std::size_t cell) {
+    const auto [it, fresh] = slot.try_emplace(cell, idx.size());
+    if (fresh) { idx.push_back(cell); sums.emplace_back(); counts.push_back(0); }
+    return it->second;
+  }
+
+  // Moves the accumulated cells out in index order and resets for the next chunk.
+  void flush(AttrPart& P) {
+    order.resize(idx.size());
+    for (std::size_t k = 0; k < order.size(); ++k) order[k] = k;
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return idx[a] < idx[b]; });
+    P.idx.reserve(order.size()); P.sums.reserve(order.size()); P.counts.reserve(order.size());
+    for (const std::size_t k : order) {
+      P.idx.push_back(idx[k]); P.sums.push_back(sums[k]); P.counts.push_back(counts[k]);
+    }
+    slot.clear(); idx.clear(); sums.clear(); counts.clear();
+  }
+};
+
+} // namespace
+
+ISAttribution attribute_is(const Fills& F, const Snaps& M, double p0,
+                           const AttributionSpec& spec, unsigned threads) {
+  assert(!F.empty() && !M.empty());
+
+  ISAttribution A;
+  A.spec = spec;
+
+  // Key pass: time range and venue ids, so every chunk indexes the same table.
+  std::vector<int> venue_id(F.size(), 0);
+  if (!spec.by_venue) A.venues.push_back("ALL");
+  double t_min = F.front().time, t_max = F.front().time;
+  int last_venue = -1;
+  for (std::size_t i = 0; i < F.size(); ++i) {
+    t_min = std::min(t_min, F[i].time);
+    t_max = std::max(t_max, F[i].time);
+    if (spec.by_venue) venue_id[i] = intern_venue(A.venues, F[i].venue, last_venue);
+  }
+
+  const bool by_time = spec.time_bucket_s > 0.0;
+  const double b0 = by_time ? std::floor(t_min / spec.time_bucket_s) : 0.0;
+  A.time_origin = by_time ? b0 * spec.time_bucket_s : t_min;
+
+  // Bound the index space before casting: a tiny bucket over a long day would
+  // otherwise overflow the int time_bucket or describe an absurd table.
+  const double nt_d = by_time ? std::floor(t_max / spec.time_bucket_s) - b0 + 1.0 : 1.0;
+  const std::size_t ns = spec.size_edges.size() + 1;
+  const std::size_t nd = spec.by_side ? 2 : 1;
+  const double cells_d = nt_d * static_cast<double>(A.venues.size() * ns * nd);
+  if (!(cells_d <= static_cast<double>(kMaxAttributionCells)))
+    throw std::invalid_argument("attribute_is: table would exceed " + std::to_string(kMaxAttributionCells) +
+                                " cells; coarsen time_bucket_s or size_edges");
+  const std::size_t nt = static_cast<std::size_t>(nt_d);
+
+  // Each chunk yields a sparse partial of its non-empty cells; partials are
+  // merged in a fixed tree, so the grouping of terms depends on n alone.
+  // Workers accumulate through one reusable scratch each, so memory scales
+  // with the cells actually hit rather than chunks x table size.
+  const ChunkPlan plan = plan_chunks(F.size());
+  std::vector<AttrPart> parts(plan.chunks);
+  parallel_for(plan.chunks, threads, [&](std::size_t cb, std::size_t ce) {
+    AttrScratch S;
+    for (std::size_t ch = cb; ch < ce; ++ch) {
+      AttrPart& P = parts[ch];
+      AsOfCursor cur(M);
+      for (std::size_t i = plan.begin(ch); i < plan.end(ch); ++i) {
+        const Fill& f = F[i];
+        const std::size_t v = static_cast<std::size_t>(venue_id[i]);
+        const std::size_t t = by_time
+            ? static_cast<std::size_t>(std::floor(f.time / spec.time_bucket_s) - b0) : 0;
+        const std::size_t s = static_cast<std::size_t>(
+            std::upper_bound(spec.size_edges.begin(), spec.size_edges.end(), f.qty) - spec.size_edges.begin());
+        const std::size_t d = (spec.by_side && f.side == Side::SELL) ? 1 : 0;
+        const std::size_t k = S.at(((v * nt + t) * ns + s) * nd + d);
+
+        const double mid_i = cur.at(f.time).mid;
+        const double sign = (f.side == Side::BUY) ? 1.0 : -1.0;
+        const double spread = std::max(sign * (f.px - mid_i), 0.0) * f.qty;
+        const double fees = f.qty * f.px * (f.fee_bps / 1e4);
+
+        ISSums& c = S.sums[k];
+        c.qty += f.qty;         P.total.qty += f.qty;
+        c.paid += f.qty * f.px; P.total.paid += f.qty * f.px;
+        c.spread += spread;     P.total.spread += spread;
+        c.fees += fees;         P.total.fees += fees;
+        ++S.counts[k];
+      }
+      S.flush(P);
+    }
+  });
+  auto combine = [](const AttrPart& a, const AttrPart& b) { return merge_parts(a, b); };
+  const AttrPart tab = pairwise_combine(parts, 0, parts.size(), combine);
+
+  const ISSums& total = tab.total;
+
+  const int sign0 = (F.front().side == Side::BUY) ? +1 : -1;
+  const double mid_end = M.back().mid;
+  const double denom = total.qty * p0;
+  A.total = finalize_is(total, p0, mid_end, sign0);
+
+  A.cells.reserve(tab.idx.size());
+  for (std::size_t k = 0; k < tab.idx.size(); ++k) {
+    const ISSums& c = tab.sums[k];
+
+    AttributionCell cell;
+    std::size_t r = tab.idx[k];
+    cell.side        = spec.by_side ? ((r % nd == 0) ? +1 : -1) : 0; r /= nd;
+    cell.size_bucket = static_cast<int>(r % ns); r /= ns;
+    cell.time_bucket = static_cast<int>(r % nt); r /= nt;
+    cell.venue       = static_cast<int>(r);
+    cell.fills    = tab.counts[k];
+    cell.qty      = c.qty;
+    cell.notional = c.paid;
+
+    ISBreakdown& b = cell.contrib;
+    b.is_bps       = sign0 * (c.paid - c.qty * p0) / denom * 1e4;
+    b.spread_bps   = c.spread / denom * 1e4;
+    b.fees_bps     = c.fees / denom * 1e4;
+    b.timing_bps   = c.qty * sign0 * (mid_end - p0) / denom * 1e4;
+    b.residual_bps = b.is_bps - b.spread_bps - b.fees_bps - b.timing_bps;
+    A.cells.push_back(cell);
+  }
+  return A;
+}
+
+} // namespace tca
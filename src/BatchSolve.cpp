@@ -0,0 +1,109 @@
+#include "../include/tca/BatchSolve.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace tca {
+
+namespace {
+
+constexpr std::size_t kTile = 512;       // systems per tile; k=4 keeps a tile in L2
+constexpr double kRelPivot = 1e-12;
+
+} // namespace
+
+void batched_cholesky_solve(BatchedSPD& S, BatchedSolution& out) {
+  const int k = S.k;
+  const std::size_t N = S.batch;
+  if (k < 1) throw std::invalid_argument("batched cholesky: k must be >= 1");
+  if (S.A.size() != static_cast<std::size_t>(k * k) * N || S.rhs.size() != static_cast<std::size_t>(k) * N)
+    throw std::invalid_argument("batched cholesky: storage does not match k x batch");
+
+  out.x.assign(static_cast<std::size_t>(k) * N, 0.0);
+  out.inv_diag.assign(static_cast<std::size_t>(k) * N, 0.0);
+  out.ok.assign(N, 1);
+
+  auto A   = [&](int i, int j) { return S.A.data() + static_cast<std::size_t>(i * k + j) * N; };
+  auto R   = [&](int i)        { return S.rhs.data() + static_cast<std::size_t>(i) * N; };
+  auto X   = [&](int i)        { return out.x.data() + static_cast<std::size_t>(i) * N; };
+  auto IV  = [&](int i)        { return out.inv_diag.data() + static_cast<std::size_t>(i) * N; };
+  unsigned char* ok = out.ok.data();
+
+  // 1/L(j,j) per tile and the inverse factor W = L^-1, interleaved like A.
+  std::vector<double> rdiag(static_cast<std::size_t>(k) * kTile);
+  std::vector<double> W(static_cast<std::size_t>(k * k) * kTile);
+  auto RD = [&](int j)        { return rdiag.data() + static_cast<std::size_t>(j) * kTile; };
+  auto Wp = [&](int i, int j) { return W.data() + static_cast<std::size_t>(i * k + j) * kTile; };
+
+  for (std::size_t t0 = 0; t0 < N; t0 += kTile) {
+    const std::size_t T = std::min(kTile, N - t0);
+
+    // Factor: column j of L from the already-final columns 0..j-1.
+    for (int j = 0; j < k; ++j) {
+      double* __restrict ajj = A(j, j) + t0;
+      double* __restrict rd = RD(j);
+      for (std::size_t b = 0; b < T; ++b) {
+        double d = ajj[b];
+        for (int m = 0; m < j; ++m) { const double l = A(j, m)[t0 + b]; d -= l * l; }
+        const bool good = d > kRelPivot * ajj[b];
+        ok[t0 + b] &= static_cast<unsigned char>(good);
+        const double piv = std::sqrt(good ? d : 1.0);
+        ajj[b] = piv;
+        rd[b] = 1.0 / piv;
+      }
+      for (int i = j + 1; i < k; ++i) {
+        double* __restrict aij = A(i, j) + t0;
+        for (std::size_t b = 0; b < T; ++b) {
+          double s = aij[b];
+          for (int m = 0; m < j; ++m) s -= A(i, m)[t0 + b] * A(j, m)[t0 + b];
+          aij[b] = s * rd[b];
+        }
+      }
+    }
+
+    // Forward (L z = r) then backward (L' x = z) substitution.
+    for (int i = 0; i < k; ++i) {
+      double* __restrict xi = X(i) + t0;
+      const double* __restrict ri = R(i) + t0;
+      const double* __restrict rd = RD(i);
+      for (std::size_t b = 0; b < T; ++b) {
+        double s = ri[b];
+        for (int m = 0; m < i; ++m) s -= A(i, m)[t0 + b] * X(m)[t0 + b];
+        xi[b] = s * rd[b];
+      }
+    }
+    for (int i = k - 1; i >= 0; --i) {
+      double* __restrict xi = X(i) + t0;
+      const double* __restrict rd = RD(i);
+      for (std::size_t b = 0; b < T; ++b) {
+        double s = xi[b];
+        for (int m = i + 1; m < k; ++m) s -= A(m, i)[t0 + b] * X(m)[t0 + b];
+        xi[b] = s * rd[b];
+      }
+    }
+
+    // diag(A^-1)_j = sum_{i>=j} W(i,j)^2 with W = L^-1 (lower triangular).
+    for (int j = 0; j < k; ++j) {
+      double* __restrict wjj = Wp(j, j);
+      const double* __restrict rd = RD(j);
+      for (std::size_t b = 0; b < T; ++b) wjj[b] = rd[b];
+      for (int i = j + 1; i < k; ++i) {
+        double* __restrict wij = Wp(i, j);
+        const double* __restrict ri = RD(i);
+        for (std::size_t b = 0; b < T; ++b) {
+          double s = 0.0;
+          for (int m = j; m < i; ++m) s += A(i, m)[t0 + b] * Wp(m, j)[b];
+          wij[b] = -s * ri[b];
+        }
+      }
+      double* __restrict iv = IV(j) + t0;
+      for (std::size_t b = 0; b < T; ++b) {
+        double s = 0.0;
+        for (int i = j; i < k; ++i) { const double w = Wp(i, j)[b]; s += w * w; }
+        iv[b] = s;
+      }
+    }
+  }
+}
+
+} // namespace tca
@@ -0,0 +1,185 @@
+#include "../include/tca/Bootstrap.hpp"
+#include "../include/tca/Market.hpp"
+#include "../include/tca/Parallel.hpp"
+#include "../include/tca/Rng.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace tca {
+
+std::vector<ISPartials> is_fill_partials(const Fills& F, const Snaps& M, double p0) {
+  assert(!F.empty() && !M.empty());
+  const double sign0 = (F.front().side == Side::BUY) ? 1.0 : -1.0;
+  const double mid_end = M.back().mid;
+
+  std::vector<ISPartials> out(F.size());
+  AsOfCursor cur(M);
+  for (std::size_t i = 0; i < F.size(); ++i) {
+    const Fill& f = F[i];
+    const double mid_i = cur.at(f.time).mid;
+    const double d = (f.side == Side::BUY) ? (f.px - mid_i) : (mid_i - f.px);
+    ISPartials& u = out[i];
+    u.denom  = f.qty * p0;
+    u.is     = sign0 * (f.qty * f.px - u.denom);
+    u.spread = std::max(d, 0.0) * f.qty;
+    u.fees   = f.qty * f.px * (f.fee_bps / 1e4);
+    u.timing = f.qty * sign0 * (mid_end - p0);
+  }
+  return out;
+}
+
+ISPartials is_partials(const Fills& F, const Snaps& M, double p0) {
+  ISPartials o;
+  for (const auto& u : is_fill_partials(F, M, p0)) {
+    o.denom += u.denom; o.is += u.is; o.spread += u.spread; o.fees += u.fees; o.timing += u.timing;
+  }
+  return o;
+}
+
+namespace {
+
+constexpr std::size_t kComponents = 5;   // is, spread, fees, timing, residual
+using Stat = std::array<double, kComponents>;
+
+struct Acc {
+  double denom = 0.0, is = 0.0, spread = 0.0, fees = 0.0, timing = 0.0;
+  std::size_t n = 0;
+
+  void add(const ISPartials& u, ISWeighting w) {
+    if (w == ISWeighting::Notional) {
+      denom += u.denom; is += u.is; spread += u.spread; fees += u.fees; timing += u.timing;
+    } else if (u.denom != 0.0) {
+      // Equal weighting: each unit contributes its own bps.
+      is += u.is / u.denom; spread += u.spread / u.denom;
+      fees += u.fees / u.denom; timing += u.timing / u.denom;
+      ++n;
+    }
+  }
+
+  Stat stat() const {
+    const double d = (n > 0) ? static_cast<double>(n) : denom;
+    Stat s{is / d * 1e4, spread / d * 1e4, fees / d * 1e4, timing / d * 1e4, 0.0};
+    s[4] = s[0] - s[1] - s[2] - s[3];
+    return s;
+  }
+};
+
+double percentile(const std::vector<double>& sorted, double q) {
+  const double pos = q * static_cast<double>(sorted.size() - 1);
+  const std::size_t i = static_cast<std::size_t>(pos);
+  if (i + 1 >= sorted.size()) return sorted.back();
+  const double w = pos - static_cast<double>(i);
+  return sorted[i] * (1.0 - w) + sorted[i + 1] * w;
+}
+
+} // namespace
+
+ISBootstrap bootstrap_is(const std::vector<ISPartials>& units, const BootstrapConfig& cfg) {
+  if (units.empty()) throw std::invalid_argument("bootstrap_is: no units");
+  if (cfg.replicates < 2) throw std::invalid_argument("bootstrap_is: need >= 2 replicates");
+  if (!(cfg.alpha > 0.0 && cfg.alpha < 1.0)) throw std::invalid_argument("bootstrap_is: alpha must be in (0,1)");
+
+  const std::size_t n = units.size();
+  const std::size_t R = cfg.replicates;
+
+  Acc full;
+  for (const auto& u : units) full.add(u, cfg.weighting);
+  const Stat point = full.stat();
+
+  // Replicate-major results; each replicate is written by exactly one worker.
+  std::vector<Stat> reps(R);
+  parallel_for(R, cfg.threads, [&](std::size_t b, std::size_t e) {
+    for (std::size_t r = b; r < e; ++r) {
+      Acc a;
+      for (std::size_t k = 0; k < n; ++k) {
+        a.add(units[draw_index(counter_draw(cfg.seed, r, k), n)], cfg.weighting);
+      }
+      reps[r] = a.stat();
+    }
+  });
+
+  ISBootstrap out;
+  out.units = n;
+  out.replicates = R;
+  Interval* dst[kComponents] = {&out.is, &out.spread, &out.fees, &out.timing, &out.residual};
+  std::vector<double> col(R);
+  for (std::size_t c = 0; c < kComponents; ++c) {
+    double mean = 0.0;
+    for (std::size_t r = 0; r < R; ++r) { col[r] = reps[r][c]; mean += col[r]; }
+    mean /= static_cast<double>(R);
+    double ss = 0.0;
+    for (double v : col) ss += (v - mean) * (v - mean);
+    std::sort(col.begin(), col.end());
+
+    Interval& iv = *dst[c];
+    iv.estimate = point[c];
+    iv.se = std::sqrt(ss / static_cast<double>(R - 1));
+    iv.lo = percentile(col, cfg.alpha / 2.0);
+    iv.hi = percentile(col, 1.0 - cfg.alpha / 2.0);
+  }
+  return out;
+}
+
+ImpactBootstrap bootstrap_impact(const std::vector<NormalEquations>& blocks, const BootstrapConfig& cfg) {
+  if (blocks.size() < 2) throw std::invalid_argument("bootstrap_impact: need >= 2 blocks");
+  if (cfg.replicates < 2) throw std::invalid_argument("bootstrap_impact: need >= 2 replicates");
+  if (!(cfg.alpha > 0.0 && cfg.alpha < 1.0)) throw std::invalid_argument("bootstrap_impact: alpha must be in (0,1)");
+
+  const std::size_t B = blocks.size();
+  const std::size_t R = cfg.replicates;
+  const Eigen::Index k = blocks.front().k();
+
+  NormalEquations full(k);
+  for (const auto& b : blocks) full.merge(b);
+  const ImpactFit point = solve_normal_equations(full);
+
+  // Replicate-major coefficients; NaN marks a singular resample.
+  std::vector<Eigen::VectorXd> reps(R);
+  parallel_for(R, cfg.threads, [&](std::size_t b, std::size_t e) {
+    NormalEquations acc(k);
+    for (std::size_t r = b; r < e; ++r) {
+      acc.XtX.setZero(); acc.Xty.setZero(); acc.yty = 0.0; acc.n = 0;
+      for (std::size_t j = 0; j < B; ++j) acc.merge(blocks[draw_index(counter_draw(cfg.seed, r, j), B)]);
+      try {
+        reps[r] = solve_normal_equations(acc).coef;
+      } catch (const std::exception&) {
+        reps[r] = Eigen::VectorXd::Constant(k, std::numeric_limits<double>::quiet_NaN());
+      }
+    }
+  });
+
+  ImpactBootstrap out;
+  out.blocks = B;
+  std::vector<std::size_t> ok;
+  ok.reserve(R);
+  for (std::size_t r = 0; r < R; ++r) if (!std::isnan(reps[r](0))) ok.push_back(r);
+  out.replicates = ok.size();
+  out.singular = R - ok.size();
+  if (ok.size() < 2) throw std::runtime_error("bootstrap_impact: too few solvable replicates");
+
+  std::vector<double> col(ok.size());
+  out.coef.resize(static_cast<std::size_t>(k));
+  for (Eigen::Index c = 0; c < k; ++c) {
+    double mean = 0.0;
+    for (std::size_t i = 0; i < ok.size(); ++i) { col[i] = reps[ok[i]](c); mean += col[i]; }
+    mean /= static_cast<double>(ok.size());
+    double ss = 0.0;
+    for (double v : col) ss += (v - mean) * (v - mean);
+    std::sort(col.begin(), col.end());
+
+    Interval& iv = out.coef[static_cast<std::size_t>(c)];
+    iv.estimate = point.coef(c);
+    iv.se = std::sqrt(ss / static_cast<double>(ok.size() - 1));
+    iv.lo = percentile(col, cfg.alpha / 2.0);
+    iv.hi = percentile(col, 1.0 - cfg.alpha / 2.0);
+  }
+  const Interval& s = out.coef[1];
+  out.eta = {s.estimate * 0.1, s.se * 0.1, s.lo * 0.1, s.hi * 0.1};
+  return out;
+}
+
+} // namespace tca
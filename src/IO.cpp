@@ -1,8 +1,10 @@
 #include "../include/tca/utils.hpp"
 #include "../include/tca/IO.hpp"
+#include "../include/tca/ImpactJson.hpp"
 #include <fstream>
 #include <algorithm>
 #include <stdexcept>
+#include <nlohmann/json.hpp>
 
 namespace tca {
 
@@ -60,4 +62,12 @@ Snaps load_snaps_csv(const std::string& path) {
   return v;
 }
 
+ImpactParams load_impact_json(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open " + path);
+  nlohmann::json j;
+  in >> j;
+  return j.get<ImpactParams>();
+}
+
 } // namespace tca
@@ -1,40 +1,109 @@
 #include "../include/tca/IS.hpp"
+#include "../include/tca/ISKernel.hpp"
 #include "../include/tca/Market.hpp"
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
 
 namespace tca {
+    ISBreakdown finalize_is(const ISSums& s, double p0, double mid_end, int sign) {
+        const double denom = s.qty * p0;
+        const double is_dollars = sign * (s.paid - denom);   // positive = cost for the side
+        const double is_bps     = (is_dollars / denom) * 1e4;
+
+        const double timing_dollars = s.qty * sign * (mid_end - p0);
+
+        const double spread_bps   = (s.spread / denom) * 1e4;
+        const double fees_bps     = (s.fees / denom) * 1e4;
+        const double timing_bps   = (timing_dollars / denom) * 1e4;
+        const double residual_bps = is_bps - spread_bps - fees_bps - timing_bps;
+
+        return ISBreakdown{is_bps, spread_bps, fees_bps, timing_bps, residual_bps};
+    }
+
     ISBreakdown compute_is(const std::vector<Fill>& F, const std::vector<Snap>& M, double p0) {
         assert(!F.empty() && !M.empty());
+        return compute_is_columnar(make_fill_columns(F, M), M, p0);
+    }
 
-        double Q = 0.0;
-        double paid = 0.0;
-        double spread_cost = 0.0;
-        double fees = 0.0;
+    ISBreakdown compute_is_scalar(const std::vector<Fill>& F, const std::vector<Snap>& M, double p0) {
+        assert(!F.empty() && !M.empty());
 
+        ISSums s;
         for (const auto& f : F) {
-            Q += f.qty;
-            paid += f.qty * f.px;
+            s.qty += f.qty;
+            s.paid += f.qty * f.px;
             const double mid_i = mid_at_or_before(M, f.time);
             const double d = (f.side == Side::BUY) ? (f.px - mid_i) : (mid_i - f.px);
-            if (d > 0) spread_cost += d * f.qty;
+            if (d > 0) s.spread += d * f.qty;
 
-            fees += f.qty * f.px * (f.fee_bps / 1e4);
+            s.fees += f.qty * f.px * (f.fee_bps / 1e4);
         }
-        const double denom = Q * p0;
-        const double is_dollars = paid - denom;
-        const double is_bps     = (is_dollars / denom) * 1e4;
 
-        const double mid_end = M.back().mid;
         const int sign = (F.front().side == Side::BUY) ? +1 : -1;
-        const double timing_dollars = Q * sign * (mid_end - p0);
+        return finalize_is(s, p0, M.back().mid, sign);
+    }
 
-        const double spread_bps   = (spread_cost / denom) * 1e4;
-        const double fees_bps     = (fees        / denom) * 1e4;
-        const double timing_bps   = (timing_dollars / denom) * 1e4;
-        const double residual_bps = is_bps - spread_bps - fees_bps - timing_bps;
+    BenchmarkIS compute_is_benchmarks(const std::vector<Fill>& F, const std::vector<Snap>& M,
+                                      double p0, double prev_close) {
+        assert(!F.empty() && !M.empty());
+        const double nan = std::numeric_limits<double>::quiet_NaN();
 
-        return ISBreakdown{is_bps, spread_bps, fees_bps, timing_bps, residual_bps};
+        // Snap j is "in force" from M[j].time until M[j+1].time; the fill loop
+        // drags j forward and charges each snap's mid for the time it was live.
+        AsOfCursor cur(M);
+        cur.at(F.front().time);
+        std::size_t j = cur.index();
+        const double t_first = F.front().time;
+        double t_cur = t_first;
+        double twap_acc = 0.0;
+        double vwap_num = M[j].mid * M[j].volume;
+        double vwap_den = M[j].volume;
+
+        ISSums s;
+        for (const auto& f : F) {
+            assert(f.time >= t_cur);
+            while (j + 1 < M.size() && M[j + 1].time <= f.time) {
+                twap_acc += M[j].mid * (M[j + 1].time - t_cur);
+                t_cur = M[j + 1].time;
+                ++j;
+                vwap_num += M[j].mid * M[j].volume;
+                vwap_den += M[j].volume;
+            }
+            twap_acc += M[j].mid * (f.time - t_cur);
+            t_cur = f.time;
+
+            const double mid_i = M[j].mid;
+            const double d = (f.side == Side::BUY) ? (f.px - mid_i) : (mid_i - f.px);
+            s.qty += f.qty;
+            s.paid += f.qty * f.px;
+            s.spread += std::max(d, 0.0) * f.qty;
+            s.fees += f.qty * f.px * (f.fee_bps / 1e4);
+        }
+
+        const int sign = (F.front().side == Side::BUY) ? +1 : -1;
+        const double span = t_cur - t_first;
+
+        BenchmarkIS b;
+        b.px.arrival       = p0;
+        b.px.interval_vwap = (vwap_den > 0.0) ? vwap_num / vwap_den : nan;
+        b.px.interval_twap = (span > 0.0) ? twap_acc / span : M[j].mid;
+        b.px.open          = M.front().mid;
+        b.px.prev_close    = (prev_close > 0.0) ? prev_close : nan;
+        b.px.end_mid       = M[j].mid;
+
+        b.arrival = finalize_is(s, p0, b.px.end_mid, sign);
+        b.avg_px  = s.paid / s.qty;
+
+        auto slip = [&](double ref) { return sign * (b.avg_px - ref) / ref * 1e4; };
+        b.vs_arrival_bps    = slip(b.px.arrival);
+        b.vs_vwap_bps       = slip(b.px.interval_vwap);
+        b.vs_twap_bps       = slip(b.px.interval_twap);
+        b.vs_open_bps       = slip(b.px.open);
+        b.vs_prev_close_bps = slip(b.px.prev_close);
+        b.vs_end_bps        = slip(b.px.end_mid);
+        return b;
     }
 
     double infer_arrival_mid(const std::vector<Fill>& F, const std::vector<Snap>& M) {
@@ -0,0 +1,221 @@
+#include "../include/tca/ISKernel.hpp"
+#include "../include/tca/Market.hpp"
+#include "../include/tca/Reduce.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TCA_X86_KERNELS 1
+#endif
+
+namespace tca {
+
+FillColumns make_fill_columns(const Fills& F, const Snaps& M) {
+  assert(!M.empty());
+  FillColumns C;
+  const std::size_t n = F.size();
+  C.qty.resize(n);
+  C.px.resize(n);
+  C.sign.resize(n);
+  C.fee_bps.resize(n);
+  C.mid.resize(n);
+
+  AsOfCursor cur(M);
+  for (std::size_t i = 0; i < n; ++i) {
+    const Fill& f = F[i];
+    C.qty[i]     = f.qty;
+    C.px[i]      = f.px;
+    C.sign[i]    = (f.side == Side::BUY) ? 1.0 : -1.0;
+    C.fee_bps[i] = f.fee_bps;
+    C.mid[i]     = cur.at(f.time).mid;
+  }
+  return C;
+}
+
+static ISSums is_sums_scalar(const FillColumns& C, std::size_t b, std::size_t e) {
+  ISSums s;
+  for (std::size_t i = b; i < e; ++i) {
+    const double q = C.qty[i];
+    const double p = C.px[i];
+    const double d = C.sign[i] * (p - C.mid[i]);
+    s.qty    += q;
+    s.paid   += q * p;
+    s.spread += std::max(d, 0.0) * q;
+    s.fees   += q * p * (C.fee_bps[i] / 1e4);
+  }
+  return s;
+}
+
+#ifdef TCA_X86_KERNELS
+
+__attribute__((target("avx2")))
+static double hsum256(__m256d v) {
+  alignas(32) double t[4];
+  _mm256_store_pd(t, v);
+  return (t[0] + t[1]) + (t[2] + t[3]);
+}
+
+__attribute__((target("avx2,fma")))
+static ISSums is_sums_avx2(const FillColumns& C, std::size_t b, std::size_t e) {
+  const double* q = C.qty.data();
+  const double* p = C.px.data();
+  const double* sg = C.sign.data();
+  const double* fb = C.fee_bps.data();
+  const double* m = C.mid.data();
+
+  __m256d aq = _mm256_setzero_pd(), ap = _mm256_setzero_pd();
+  __m256d as = _mm256_setzero_pd(), af = _mm256_setzero_pd();
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d inv = _mm256_set1_pd(1.0 / 1e4);
+
+  std::size_t i = b;
+  for (; i + 4 <= e; i += 4) {
+    const __m256d vq = _mm256_loadu_pd(q + i);
+    const __m256d vp = _mm256_loadu_pd(p + i);
+    const __m256d vd = _mm256_mul_pd(_mm256_loadu_pd(sg + i), _mm256_sub_pd(vp, _mm256_loadu_pd(m + i)));
+    const __m256d notional = _mm256_mul_pd(vq, vp);
+    aq = _mm256_add_pd(aq, vq);
+    ap = _mm256_add_pd(ap, notional);
+    as = _mm256_fmadd_pd(_mm256_max_pd(vd, zero), vq, as);
+    af = _mm256_fmadd_pd(notional, _mm256_mul_pd(_mm256_loadu_pd(fb + i), inv), af);
+  }
+
+  ISSums s;
+  s.qty = hsum256(aq);
+  s.paid = hsum256(ap);
+  s.spread = hsum256(as);
+  s.fees = hsum256(af);
+  const ISSums tail = is_sums_scalar(C, i, e);
+  s.qty += tail.qty; s.paid += tail.paid; s.spread += tail.spread; s.fees += tail.fees;
+  return s;
+}
+
+__attribute__((target("avx512f")))
+static double hsum512(__m512d v) {
+  alignas(64) double t[8];
+  _mm512_store_pd(t, v);
+  return ((t[0] + t[1]) + (t[2] + t[3])) + ((t[4] + t[5]) + (t[6] + t[7]));
+}
+
+__attribute__((target("avx512f")))
+static ISSums is_sums_avx512(const FillColumns& C, std::size_t b, std::size_t e) {
+  const double* q = C.qty.data();
+  const double* p = C.px.data();
+  const double* sg = C.sign.data();
+  const double* fb = C.fee_bps.data();
+  const double* m = C.mid.data();
+
+  __m512d aq = _mm512_setzero_pd(), ap = _mm512_setzero_pd();
+  __m512d as = _mm512_setzero_pd(), af = _mm512_setzero_pd();
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512d inv = _mm512_set1_pd(1.0 / 1e4);
+
+  std::size_t i = b;
+  for (; i + 8 <= e; i += 8) {
+    const __m512d vq = _mm512_loadu_pd(q + i);
+    const __m512d vp = _mm512_loadu_pd(p + i);
+    const __m512d vd = _mm512_mul_pd(_mm512_loadu_pd(sg + i), _mm512_sub_pd(vp, _mm512_loadu_pd(m + i)));
+    const __m512d notional = _mm512_mul_pd(vq, vp);
+    aq = _mm512_add_pd(aq, vq);
+    ap = _mm512_add_pd(ap, notional);
+    // max(d, 0) as a masked blend; keeps the positive part branch-free.
+    const __m512d pos = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(vd, zero, _CMP_GT_OQ), zero, vd);
+    as = _mm512_fmadd_pd(pos, vq, as);
+    af = _mm512_fmadd_pd(notional, _mm512_mul_pd(_mm512_loadu_pd(fb + i), inv), af);
+  }
+
+  ISSums s;
+  s.qty = hsum512(aq);
+  s.paid = hsum512(ap);
+  s.spread = hsum512(as);
+  s.fees = hsum512(af);
+  const ISSums tail = is_sums_scalar(C, i, e);
+  s.qty += tail.qty; s.paid += tail.paid; s.spread += tail.spread; s.fees += tail.fees;
+  return s;
+}
+
+#endif // TCA_X86_KERNELS
+
+static SimdLevel detect_simd_level() {
+#ifdef TCA_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+#endif
+  return SimdLevel::Scalar;
+}
+
+SimdLevel active_simd_level() {
+  static const SimdLevel level = detect_simd_level();
+  return level;
+}
+
+const char* to_string(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::AVX512: return "avx512";
+    case SimdLevel::AVX2:   return "avx2";
+    case SimdLevel::Scalar: break;
+  }
+  return "scalar";
+}
+
+ISSums is_sums_columnar(const FillColumns& C, std::size_t b, std::size_t e, SimdLevel level) {
+  assert(b <= e && e <= C.size());
+#ifdef TCA_X86_KERNELS
+  if (level == SimdLevel::AVX512) return is_sums_avx512(C, b, e);
+  if (level == SimdLevel::AVX2)   return is_sums_avx2(C, b, e);
+#else
+  (void)level;
+#endif
+  return is_sums_scalar(C, b, e);
+}
+
+ISSums is_sums_columnar(const FillColumns& C, std::size_t b, std::size_t e) {
+  return is_sums_columnar(C, b, e, active_simd_level());
+}
+
+ISSums is_sums_parallel(const FillColumns& C, unsigned threads) {
+  const SimdLevel level = active_simd_level();
+  return deterministic_reduce(C.size(), threads, ISSums{},
+    [&](std::size_t b, std::size_t e) { return is_sums_columnar(C, b, e, level); },
+    [](ISSums a, const ISSums& b) {
+      a.qty += b.qty; a.paid += b.paid; a.spread += b.spread; a.fees += b.fees;
+      return a;
+    });
+}
+
+ISBreakdown compute_is_columnar(const FillColumns& C, const Snaps& M, double p0, unsigned threads) {
+  assert(C.size() > 0 && !M.empty());
+  const ISSums s = is_sums_parallel(C, threads);
+  return finalize_is(s, p0, M.back().mid, C.sign.front() > 0.0 ? +1 : -1);
+}
+
+ISBreakdown compute_is_columnar(const FillColumns& C, const Snaps& M, double p0, SimdLevel level) {
+  assert(C.size() > 0 && !M.empty());
+  const ISSums s = is_sums_columnar(C, 0, C.size(), level);
+  return finalize_is(s, p0, M.back().mid, C.sign.front() > 0.0 ? +1 : -1);
+}
+
+static double max_abs_diff(const ISBreakdown& a, const ISBreakdown& b) {
+  return std::max({std::abs(a.is_bps - b.is_bps), std::abs(a.spread_bps - b.spread_bps),
+                   std::abs(a.fees_bps - b.fees_bps), std::abs(a.timing_bps - b.timing_bps),
+                   std::abs(a.residual_bps - b.residual_bps)});
+}
+
+ISKernelCheck check_is_kernels(const Fills& F, const Snaps& M, double p0, unsigned threads) {
+  const ISBreakdown ref = compute_is_scalar(F, M, p0);
+  const FillColumns C = make_fill_columns(F, M);
+  const SimdLevel top = active_simd_level();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  ISKernelCheck r;
+  r.scalar = max_abs_diff(compute_is_columnar(C, M, p0, SimdLevel::Scalar), ref);
+  r.avx2 = top != SimdLevel::Scalar ? max_abs_diff(compute_is_columnar(C, M, p0, SimdLevel::AVX2), ref) : nan;
+  r.avx512 = top == SimdLevel::AVX512 ? max_abs_diff(compute_is_columnar(C, M, p0, SimdLevel::AVX512), ref) : nan;
+  r.parallel = max_abs_diff(compute_is_columnar(C, M, p0, threads), ref);
+  return r;
+}
+
+} // namespace tca
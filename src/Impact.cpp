@@ -1,6 +1,10 @@
 #include "../include/tca/Impact.hpp"
+#include "../include/tca/BatchSolve.hpp"
 #include "../include/tca/Market.hpp"
+#include "../include/tca/Reduce.hpp"
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <stdexcept>
 
 namespace tca {
@@ -14,40 +18,28 @@ namespace tca {
         ++n;
     }
 
-    int k = 2;
-    if (include_spread_control) ++k;
-    if (include_sigma_control)  ++k;
+    const int k = temp_impact_columns(include_spread_control, include_sigma_control);
 
     RegrData D;
     D.X.resize(n, k);
     D.y.resize(n);
     D.kept_rows.reserve(n);
 
+    AsOfCursor cur(snaps);
+    double row[4];
     std::size_t r = 0;
     for (std::size_t i = 0; i < fills.size(); ++i) {
         const auto& f = fills[i];
-        const double mid_pre = mid_at_or_before(snaps, f.time);
-        const double signed_slip_bps =
-        ((f.side == Side::BUY) ? (f.px - mid_pre) : (mid_pre - f.px)) / mid_pre * 1e4;
 
         // We need a volume estimate at (or near) this time; use nearest snap at/before f.t
         // In this simple builder we reuse the same snap as for mid.
-        // (You can refine by slice-bucketing later.)
-        auto it = std::upper_bound(snaps.begin(), snaps.end(), f.time,
-        [](double tt, const Snap& s){ return tt < s.time; });
-        const Snap& sref = (it == snaps.begin()) ? snaps.front() : *std::prev(it);
-
-        const double pov_i = pov(f.qty, sref.volume);
-        const double signed_pov = ((f.side == Side::BUY) ? +1.0 : -1.0) * pov_i;
-
-        // Row r
-        int c = 0;
-        D.X(r, c++) = 1.0;            // intercept
-        D.X(r, c++) = signed_pov;     // main regressor
-        if (include_spread_control) D.X(r, c++) = sref.spread_bps;
-        if (include_sigma_control)  D.X(r, c++) = sref.sigma;
-
-        D.y(r) = signed_slip_bps;
+        // (build_bucketed_impact_design aggregates per interval instead.)
+        const Snap& sref = cur.at(f.time);
+
+        double y = 0.0;
+        const int kk = temp_impact_row(f, sref, include_spread_control, include_sigma_control, row, y);
+        for (int c = 0; c < kk; ++c) D.X(r, c) = row[c];
+        D.y(r) = y;
         D.kept_rows.push_back(i);
         ++r;
     }
@@ -58,6 +50,226 @@ namespace tca {
     return D;
     }
 
+    ImpactColumns build_impact_columns(const Fills& fills, const Snaps& snaps) {
+    ImpactColumns C;
+    const std::size_t n = fills.size();
+    C.sign.resize(n); C.pov.resize(n); C.spread.resize(n); C.sigma.resize(n); C.y.resize(n);
+    AsOfCursor cur(snaps);
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto& f = fills[i];
+        const Snap& sref = cur.at(f.time);
+        const double s = (f.side == Side::BUY) ? +1.0 : -1.0;
+        C.sign[i]   = s;
+        C.pov[i]    = pov(f.qty, sref.volume);
+        C.spread[i] = sref.spread_bps;
+        C.sigma[i]  = sref.sigma;
+        C.y[i]      = s * (f.px - sref.mid) / sref.mid * 1e4;
+    }
+    return C;
+    }
+
+    RegrData build_bucketed_impact_design(const Fills& fills,
+                                          const Snaps& snaps,
+                                          bool include_spread_control,
+                                          bool include_sigma_control) {
+    const int k = temp_impact_columns(include_spread_control, include_sigma_control);
+    struct Bucket { double qty = 0.0, notional = 0.0; };
+
+    RegrData D;
+    std::vector<double> X;   // row-major staging; rows are unknown until the end
+    std::vector<double> y;
+
+    Bucket side_acc[2];      // [BUY, SELL] for the current interval
+    std::size_t cur_j = 0;
+    bool open = false;
+
+    auto flush = [&]() {
+        const Snap& sj = snaps[cur_j];
+        for (int d = 0; d < 2; ++d) {
+            Bucket& b = side_acc[d];
+            if (b.qty <= 0.0) continue;
+            const double s = (d == 0) ? +1.0 : -1.0;
+            const double vwap = b.notional / b.qty;
+            X.push_back(1.0);
+            X.push_back(s * pov(b.qty, sj.volume));
+            if (include_spread_control) X.push_back(sj.spread_bps);
+            if (include_sigma_control)  X.push_back(sj.sigma);
+            y.push_back(s * (vwap - sj.mid) / sj.mid * 1e4);
+            D.kept_rows.push_back(cur_j);
+            b = Bucket{};
+        }
+    };
+
+    AsOfCursor cur(snaps);
+    for (const auto& f : fills) {
+        cur.at(f.time);
+        const std::size_t j = cur.index();
+        if (open && j != cur_j) {
+            if (j < cur_j) throw std::invalid_argument("bucketed design: fills must be time-sorted");
+            flush();
+        }
+        cur_j = j;
+        open = true;
+        Bucket& b = side_acc[(f.side == Side::BUY) ? 0 : 1];
+        b.qty += f.qty;
+        b.notional += f.qty * f.px;
+    }
+    if (open) flush();
+
+    const auto r = static_cast<Eigen::Index>(y.size());
+    D.X = Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(X.data(), r, k);
+    D.y = Eigen::Map<const Eigen::VectorXd>(y.data(), r);
+    return D;
+    }
+
+    NormalEquations gram_sums(const Eigen::MatrixXd& X, const Eigen::VectorXd& y, unsigned threads) {
+    if (X.rows() != y.size())
+        throw std::invalid_argument("X/y shapes invalid");
+    const Eigen::Index k = X.cols();
+    return deterministic_reduce(static_cast<std::size_t>(X.rows()), threads, NormalEquations(k),
+        [&](std::size_t b, std::size_t e) {
+            const auto r0 = static_cast<Eigen::Index>(b);
+            const auto m  = static_cast<Eigen::Index>(e - b);
+            NormalEquations ne(k);
+            ne.XtX.noalias() = X.middleRows(r0, m).transpose() * X.middleRows(r0, m);
+            ne.Xty.noalias() = X.middleRows(r0, m).transpose() * y.segment(r0, m);
+            ne.yty = y.segment(r0, m).squaredNorm();
+            ne.n   = e - b;
+            return ne;
+        },
+        [](NormalEquations a, const NormalEquations& b) { a.merge(b); return a; });
+    }
+
+    NormalEquations accumulate_temp_impact(const Fills& fills,
+                                           const Snaps& snaps,
+                                           bool include_spread_control,
+                                           bool include_sigma_control) {
+    NormalEquations ne(temp_impact_columns(include_spread_control, include_sigma_control));
+    AsOfCursor cur(snaps);
+    double row[4];
+    for (const auto& f : fills) {
+        double y = 0.0;
+        temp_impact_row(f, cur.at(f.time), include_spread_control, include_sigma_control, row, y);
+        ne.add(row, y);
+    }
+    return ne;
+    }
+
+    namespace {
+    // Fixed-size partial for the parallel builder; columns beyond k stay zero.
+    struct GramPartial {
+        Eigen::Matrix4d XtX = Eigen::Matrix4d::Zero();
+        Eigen::Vector4d Xty = Eigen::Vector4d::Zero();
+        double yty = 0.0;
+        std::size_t n = 0;
+    };
+    }
+
+    NormalEquations accumulate_temp_impact_parallel(const Fills& fills,
+                                                    const Snaps& snaps,
+                                                    bool include_spread_control,
+                                                    bool include_sigma_control,
+                                                    unsigned threads) {
+    const int k = temp_impact_columns(include_spread_control, include_sigma_control);
+    const GramPartial G = deterministic_reduce(fills.size(), threads, GramPartial{},
+        [&](std::size_t b, std::size_t e) {
+            GramPartial P;
+            AsOfCursor cur(snaps);
+            cur.seek(fills[b].time);
+            Eigen::Vector4d x = Eigen::Vector4d::Zero();
+            for (std::size_t i = b; i < e; ++i) {
+                double y = 0.0;
+                temp_impact_row(fills[i], cur.at(fills[i].time),
+                                include_spread_control, include_sigma_control, x.data(), y);
+                P.XtX.noalias() += x * x.transpose();
+                P.Xty += y * x;
+                P.yty += y * y;
+            }
+            P.n = e - b;
+            return P;
+        },
+        [](GramPartial a, const GramPartial& b) {
+            a.XtX += b.XtX; a.Xty += b.Xty; a.yty += b.yty; a.n += b.n;
+            return a;
+        });
+
+    NormalEquations ne(k);
+    ne.XtX = G.XtX.topLeftCorner(k, k);
+    ne.Xty = G.Xty.head(k);
+    ne.yty = G.yty;
+    ne.n   = G.n;
+    return ne;
+    }
+
+    std::vector<int> aliased_columns(const Eigen::MatrixXd& XtX, double tol) {
+    const Eigen::Index k = XtX.rows();
+    Eigen::MatrixXd L = Eigen::MatrixXd::Zero(k, k);
+    std::vector<int> kept, out;
+    for (Eigen::Index j = 0; j < k; ++j) {
+        double d = XtX(j, j);
+        for (int p : kept) d -= L(j, p) * L(j, p);
+        if (!(XtX(j, j) > 0.0) || d <= tol * XtX(j, j)) { out.push_back(static_cast<int>(j)); continue; }
+        const double ljj = std::sqrt(d);
+        L(j, j) = ljj;
+        for (Eigen::Index i = j + 1; i < k; ++i) {
+            double v = XtX(i, j);
+            for (int p : kept) v -= L(i, p) * L(j, p);
+            L(i, j) = v / ljj;
+        }
+        kept.push_back(static_cast<int>(j));
+    }
+    return out;
+    }
+
+    bool solve_unaliased(const Eigen::MatrixXd& A, const Eigen::VectorXd& r,
+                         const std::vector<int>& aliased,
+                         Eigen::VectorXd& b, Eigen::MatrixXd* inv) {
+    const Eigen::Index k = A.rows();
+    std::vector<int> kept;
+    for (int j = 0; j < static_cast<int>(k); ++j)
+        if (std::find(aliased.begin(), aliased.end(), j) == aliased.end()) kept.push_back(j);
+    const auto m = static_cast<Eigen::Index>(kept.size());
+    if (m == 0) return false;
+
+    Eigen::LDLT<Eigen::MatrixXd> ldlt(A(kept, kept));
+    if (ldlt.info() != Eigen::Success || !ldlt.isPositive() || ldlt.vectorD().minCoeff() <= 0.0)
+        return false;
+    const Eigen::VectorXd bk = ldlt.solve(r(kept));
+    b = Eigen::VectorXd::Zero(k);
+    b(kept) = bk;
+    if (inv) {
+        *inv = Eigen::MatrixXd::Zero(k, k);
+        const Eigen::MatrixXd ik = ldlt.solve(Eigen::MatrixXd::Identity(m, m));
+        (*inv)(kept, kept) = ik;
+    }
+    return true;
+    }
+
+    const char* temp_impact_column_name(int c, bool include_spread_control, bool include_sigma_control) {
+    if (c == 0) return "intercept";
+    if (c == 1) return "signed_pov";
+    if (c == 2 && include_spread_control) return "spread_bps";
+    if (include_sigma_control) return "sigma";
+    return "?";
+    }
+
+    ImpactFit solve_normal_equations(const NormalEquations& ne) {
+    const Eigen::Index k = ne.k();
+    if (k < 2 || ne.n <= static_cast<std::size_t>(k))
+        throw std::invalid_argument("normal equations: need n > k >= 2");
+
+    ImpactFit fit;
+    fit.aliased = aliased_columns(ne.XtX);
+    Eigen::VectorXd b;
+    Eigen::MatrixXd inv;
+    if ((!fit.aliased.empty() && fit.aliased.front() <= 1) ||
+        !solve_unaliased(ne.XtX, ne.Xty, fit.aliased, b, &inv))
+        throw std::runtime_error("normal equations: X'X is singular (intercept or POV aliased)");
+    ols_diagnostics(ne.XtX, ne.Xty, ne.yty, ne.n, b, inv.diagonal(),
+                    k - static_cast<Eigen::Index>(fit.aliased.size()), fit);
+    return fit;
+    }
+
     ImpactParams fit_temporary_impact_ols(const Eigen::MatrixXd& X,
                                         const Eigen::VectorXd& y) {
     if (X.rows() == 0 || X.rows() != y.size())
@@ -74,11 +286,131 @@ namespace tca {
     return p;
     }
 
+    std::vector<ImpactFit> fit_temporary_impact_ols(const std::vector<NormalEquations>& systems) {
+    std::vector<ImpactFit> fits(systems.size());
+    if (systems.empty()) return fits;
+    const int k = static_cast<int>(systems.front().k());
+    if (k < 2) throw std::invalid_argument("batched OLS: need k >= 2");
+    for (const auto& ne : systems)
+        if (ne.k() != k) throw std::invalid_argument("batched OLS: systems must share k");
+
+    const std::size_t N = systems.size();
+    BatchedSPD S(k, N);
+    for (std::size_t b = 0; b < N; ++b) {
+        const auto& ne = systems[b];
+        for (int i = 0; i < k; ++i) {
+            S.r(i, b) = ne.Xty(i);
+            for (int j = 0; j <= i; ++j) S.a(i, j, b) = ne.XtX(i, j);
+        }
+    }
+    BatchedSolution sol;
+    batched_cholesky_solve(S, sol);
+
+    // Diagnostics as in solve_normal_equations.
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    Eigen::VectorXd coef(k), inv_diag(k);
+    for (std::size_t b = 0; b < N; ++b) {
+        const auto& ne = systems[b];
+        ImpactFit& fit = fits[b];
+        if (!sol.ok[b] && ne.n > static_cast<std::size_t>(k)) {
+            try { fit = solve_normal_equations(ne); continue; }
+            catch (const std::exception&) {}
+        }
+        if (!sol.ok[b] || ne.n <= static_cast<std::size_t>(k)) {
+            fit.n = ne.n;
+            fit.coef.setConstant(k, nan);
+            fit.se.setConstant(k, nan);
+            fit.sigma2 = fit.r2 = nan;
+            fit.params.eta_bp_per_10pov = nan;
+            continue;
+        }
+        for (int i = 0; i < k; ++i) { coef(i) = sol.at(i, b, N); inv_diag(i) = sol.inv(i, b, N); }
+        ols_diagnostics(ne.XtX, ne.Xty, ne.yty, ne.n, coef, inv_diag, k, fit);
+    }
+    return fits;
+    }
+
+    std::vector<Fills> split_orders(const Fills& fills, double gap_s) {
+    std::vector<Fills> orders;
+    for (std::size_t i = 0; i < fills.size(); ++i) {
+        const auto& f = fills[i];
+        if (i == 0 || f.side != fills[i - 1].side || f.time - fills[i - 1].time > gap_s)
+            orders.emplace_back();
+        orders.back().push_back(f);
+    }
+    return orders;
+    }
+
+    PermRegrData build_perm_impact_design(const std::vector<Fills>& orders,
+                                          const Snaps& snaps,
+                                          const std::vector<double>& horizons_s) {
+    if (snaps.empty() || horizons_s.empty())
+        throw std::invalid_argument("perm design: need snaps and at least one horizon");
+    const double max_h = *std::max_element(horizons_s.begin(), horizons_s.end());
+    const auto H = static_cast<Eigen::Index>(horizons_s.size());
+
+    PermRegrData D;
+    D.horizons_s = horizons_s;
+    D.X.resize(static_cast<Eigen::Index>(orders.size()), 2);
+    D.Y.resize(static_cast<Eigen::Index>(orders.size()), H);
+
+    Eigen::Index r = 0;
+    for (std::size_t o = 0; o < orders.size(); ++o) {
+        const Fills& F = orders[o];
+        if (F.empty()) continue;
+        const double t0 = F.front().time, t1 = F.back().time;
+        if (t1 + max_h > snaps.back().time) continue;   // markout not observable
+
+        // Market volume of the snaps in force over [t0, t1].
+        AsOfCursor cur(snaps);
+        cur.seek(t0);
+        const double mid0 = cur.at(t0).mid;
+        double vol = 0.0;
+        for (std::size_t j = cur.index(); j < snaps.size() && (j == cur.index() || snaps[j].time <= t1); ++j)
+            vol += snaps[j].volume;
+
+        double Q = 0.0;
+        for (const auto& f : F) Q += f.qty;
+        const double s = (F.front().side == Side::BUY) ? +1.0 : -1.0;
+
+        D.X(r, 0) = 1.0;
+        D.X(r, 1) = s * pov(Q, vol);
+        for (Eigen::Index h = 0; h < H; ++h) {
+            const double mid_h = mid_at_or_before(snaps, t1 + horizons_s[static_cast<std::size_t>(h)]);
+            D.Y(r, h) = s * (mid_h - mid0) / mid0 * 1e4;
+        }
+        D.kept_orders.push_back(o);
+        ++r;
+    }
+    D.X.conservativeResize(r, Eigen::NoChange);
+    D.Y.conservativeResize(r, Eigen::NoChange);
+    return D;
+    }
+
+    PermanentImpactFit fit_permanent_impact_multi(const PermRegrData& D) {
+    if (D.X.rows() < 2 || D.X.rows() != D.Y.rows())
+        throw std::invalid_argument("perm fit: need >= 2 orders with observable markouts");
+
+    // One factorization, H right-hand sides.
+    const Eigen::MatrixXd W = D.X.colPivHouseholderQr().solve(D.Y);
+
+    PermanentImpactFit out;
+    out.horizons_s = D.horizons_s;
+    for (Eigen::Index h = 0; h < W.cols(); ++h)
+        out.gamma_bp_per_10pov.push_back(W(1, h) * 0.1);   // bps per 10% participation
+    return out;
+    }
+
     ImpactParams fit_permanent_impact_ols(const Eigen::MatrixXd& Xp,
                                         const Eigen::VectorXd& yp) {
-    // Stub for now (or implement similarly with a longer-horizon y)
-    (void)Xp; (void)yp;
-    return ImpactParams{};
+    if (Xp.rows() < 2 || Xp.rows() != yp.size())
+        throw std::invalid_argument("Xp/yp shapes invalid");
+
+    // Column order as in build_perm_impact_design: [intercept, signed participation]
+    const Eigen::VectorXd w = Xp.colPivHouseholderQr().solve(yp);
+    ImpactParams p;
+    p.gamma_bp_per_10pov = w(1) * 0.1;
+    return p;
     }
 
 } // namespace tca
@@ -0,0 +1,133 @@
+#include "../include/tca/ImpactCV.hpp"
+#include "../include/tca/Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace tca {
+
+namespace {
+
+// Column indices into the full [1, pov, spread, sigma] system.
+std::vector<Eigen::Index> columns_for(bool sp, bool sg) {
+  std::vector<Eigen::Index> c{0, 1};
+  if (sp) c.push_back(2);
+  if (sg) c.push_back(3);
+  return c;
+}
+
+NormalEquations select(const NormalEquations& full, const std::vector<Eigen::Index>& c) {
+  const auto k = static_cast<Eigen::Index>(c.size());
+  NormalEquations ne(k);
+  for (Eigen::Index i = 0; i < k; ++i) {
+    ne.Xty(i) = full.Xty(c[i]);
+    for (Eigen::Index j = 0; j < k; ++j) ne.XtX(i, j) = full.XtX(c[i], c[j]);
+  }
+  ne.yty = full.yty;
+  ne.n = full.n;
+  return ne;
+}
+
+// Ridge solve with a variance-scaled penalty; false when still singular.
+bool ridge_solve(const NormalEquations& ne, double lambda, Eigen::VectorXd& b) {
+  const Eigen::Index k = ne.k();
+  const double n = static_cast<double>(ne.n);
+  if (ne.n == 0) return false;
+  Eigen::MatrixXd A = ne.XtX;
+  for (Eigen::Index j = 1; j < k; ++j) {
+    const double mean = ne.XtX(0, j) / n;
+    const double var = std::max(ne.XtX(j, j) / n - mean * mean, 0.0);
+    A(j, j) += lambda * n * var;
+  }
+  Eigen::LDLT<Eigen::MatrixXd> ldlt(A);
+  if (ldlt.info() != Eigen::Success || !ldlt.isPositive() || ldlt.vectorD().minCoeff() <= 0.0) return false;
+  b = ldlt.solve(ne.Xty);
+  return true;
+}
+
+double sse_at(const NormalEquations& ne, const Eigen::VectorXd& b) {
+  return std::max(0.0, ne.yty - 2.0 * b.dot(ne.Xty) + b.dot(ne.XtX * b));
+}
+
+} // namespace
+
+ImpactCV cross_validate_impact(const std::vector<NormalEquations>& blocks, const CVOptions& opt) {
+  const std::size_t B = blocks.size();
+  if (opt.folds < 2) throw std::invalid_argument("impact cv: need >= 2 folds");
+  if (B < opt.folds) throw std::invalid_argument("impact cv: fewer blocks than folds");
+  if (opt.lambdas.empty()) throw std::invalid_argument("impact cv: empty lambda grid");
+  for (const auto& b : blocks)
+    if (b.k() != 4) throw std::invalid_argument("impact cv: blocks must carry [1, pov, spread, sigma]");
+  for (double l : opt.lambdas)
+    if (!(l >= 0.0)) throw std::invalid_argument("impact cv: lambdas must be >= 0");
+
+  const std::size_t K = opt.folds;
+  NormalEquations total(4);
+  for (const auto& b : blocks) total.merge(b);
+
+  // Fold f tests on blocks [B*f/K, B*(f+1)/K); training drops those plus a
+  // gap on either side.
+  std::vector<NormalEquations> test(K, NormalEquations(4)), train(K, total);
+  for (std::size_t f = 0; f < K; ++f) {
+    const std::size_t lo = B * f / K, hi = B * (f + 1) / K;
+    const std::size_t glo = lo >= opt.gap_blocks ? lo - opt.gap_blocks : 0;
+    const std::size_t ghi = std::min(B, hi + opt.gap_blocks);
+    for (std::size_t j = lo; j < hi; ++j) test[f].merge(blocks[j]);
+    NormalEquations held(4);
+    for (std::size_t j = glo; j < ghi; ++j) held.merge(blocks[j]);
+    train[f].XtX -= held.XtX; train[f].Xty -= held.Xty;
+    train[f].yty -= held.yty; train[f].n -= held.n;
+  }
+
+  ImpactCV out;
+  out.blocks = B;
+  out.folds = K;
+  for (int s = 0; s < 4; ++s)
+    for (double l : opt.lambdas) out.grid.push_back({(s & 1) != 0, (s & 2) != 0, l, 0.0, 0.0, 0});
+
+  parallel_for(out.grid.size(), opt.threads, [&](std::size_t gb, std::size_t ge) {
+    for (std::size_t g = gb; g < ge; ++g) {
+      CVPoint& p = out.grid[g];
+      const auto cols = columns_for(p.spread, p.sigma);
+      double sse = 0.0, ntest = 0.0, m = 0.0, m2 = 0.0;
+      std::size_t ok = 0;
+      for (std::size_t f = 0; f < K; ++f) {
+        Eigen::VectorXd b;
+        const NormalEquations te = select(test[f], cols);
+        if (te.n == 0) continue;
+        if (!ridge_solve(select(train[f], cols), p.lambda, b)) { ++p.failed; continue; }
+        const double e = sse_at(te, b);
+        sse += e;
+        ntest += static_cast<double>(te.n);
+        const double r = std::sqrt(e / static_cast<double>(te.n));
+        m += r; m2 += r * r; ++ok;
+      }
+      if (ok == 0) { p.rmse = std::numeric_limits<double>::infinity(); continue; }
+      p.rmse = std::sqrt(sse / ntest);
+      const double nf = static_cast<double>(ok);
+      const double mean = m / nf;
+      p.rmse_se = ok > 1 ? std::sqrt(std::max(m2 / nf - mean * mean, 0.0) / (nf - 1.0)) : 0.0;
+    }
+  });
+
+  for (std::size_t g = 1; g < out.grid.size(); ++g)
+    if (out.grid[g].rmse < out.grid[out.best].rmse) out.best = g;
+  const CVPoint& best = out.grid[out.best];
+  if (!std::isfinite(best.rmse)) throw std::runtime_error("impact cv: every grid point was singular");
+
+  // Refit the winner on all blocks; diagnostics follow solve_normal_equations.
+  const NormalEquations all = select(total, columns_for(best.spread, best.sigma));
+  if (best.lambda == 0.0) {
+    out.fit = solve_normal_equations(all);
+  } else {
+    Eigen::VectorXd b;
+    if (!ridge_solve(all, best.lambda, b)) throw std::runtime_error("impact cv: refit is singular");
+    const Eigen::VectorXd none = Eigen::VectorXd::Constant(all.k(), std::numeric_limits<double>::quiet_NaN());
+    ols_diagnostics(all.XtX, all.Xty, all.yty, all.n, b, none, all.k(), out.fit);
+    out.fit.se = none;   // no closed form under the penalty
+  }
+  return out;
+}
+
+} // namespace tca
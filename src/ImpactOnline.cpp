@@ -0,0 +1,55 @@
+#include "../include/tca/ImpactOnline.hpp"
+#include <stdexcept>
+
+namespace tca {
+
+RlsImpactEstimator::RlsImpactEstimator(bool include_spread_control,
+                                       bool include_sigma_control,
+                                       double forgetting,
+                                       double delta)
+  : sp_(include_spread_control),
+    sg_(include_sigma_control),
+    k_(temp_impact_columns(include_spread_control, include_sigma_control)),
+    lambda_(forgetting) {
+  if (!(forgetting > 0.0 && forgetting <= 1.0))
+    throw std::invalid_argument("RLS forgetting factor must be in (0, 1]");
+  if (!(delta > 0.0)) throw std::invalid_argument("RLS delta must be > 0");
+  w_ = Vec::Zero(k_);
+  P_ = Mat::Identity(k_, k_) * delta;
+  Px_ = Vec::Zero(k_);
+}
+
+void RlsImpactEstimator::warm_start(const Eigen::VectorXd& coef, double delta) {
+  if (coef.size() != k_) throw std::invalid_argument("RLS warm start: coefficient size mismatch");
+  w_ = coef;
+  P_ = Mat::Identity(k_, k_) * delta;
+}
+
+void RlsImpactEstimator::update(const double* x, double y) {
+  const Eigen::Map<const Vec> xv(x, k_);
+  Px_.noalias() = P_ * xv;
+  const double denom = lambda_ + xv.dot(Px_);
+  if (!(denom > 0.0)) return;   // degenerate row; keep the current state
+
+  const double err = y - w_.dot(xv);
+  w_ += (err / denom) * Px_;
+  // P <- (P - Px Px' / denom) / lambda, kept symmetric to stop rounding drift.
+  P_.noalias() -= (Px_ / denom) * Px_.transpose();
+  P_ = ((0.5 / lambda_) * (P_ + P_.transpose())).eval();
+  ++n_;
+}
+
+void RlsImpactEstimator::update(const Fill& f, const Snap& sref) {
+  double x[kMaxK];
+  double y = 0.0;
+  temp_impact_row(f, sref, sp_, sg_, x, y);
+  update(x, y);
+}
+
+ImpactParams RlsImpactEstimator::params() const {
+  ImpactParams p;
+  p.eta_bp_per_10pov = w_(1) * 0.1;
+  return p;
+}
+
+} // namespace tca
@@ -0,0 +1,172 @@
+#include "../include/tca/ImpactPanel.hpp"
+#include "../include/tca/IO.hpp"
+#include "../include/tca/ImpactJson.hpp"
+#include "../include/tca/Parallel.hpp"
+#include "../include/tca/utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <nlohmann/json.hpp>
+
+namespace tca {
+
+using nlohmann::json;
+
+const ImpactParams* ImpactTable::find(const std::string& symbol) const {
+  auto it = std::lower_bound(symbols.begin(), symbols.end(), symbol);
+  if (it == symbols.end() || *it != symbol) return nullptr;
+  return &params[static_cast<std::size_t>(it - symbols.begin())];
+}
+
+void write_impact_table_json(const std::string& path, const ImpactTable& T) {
+  json syms = json::object();
+  for (std::size_t i = 0; i < T.symbols.size(); ++i) syms[T.symbols[i]] = json(T.params[i]);
+  json j{{"pooled", json(T.pooled)}, {"symbols", syms}};
+  std::ofstream out(path);
+  if (!out) throw std::runtime_error("cannot write " + path);
+  out << j.dump(2);
+}
+
+ImpactTable load_impact_table_json(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open " + path);
+  json j;
+  in >> j;
+  ImpactTable T;
+  if (j.contains("pooled")) T.pooled = j.at("pooled").get<ImpactParams>();
+  if (j.contains("symbols")) {
+    // nlohmann objects iterate in key order, so symbols come out sorted.
+    for (auto it = j.at("symbols").begin(); it != j.at("symbols").end(); ++it) {
+      T.symbols.push_back(it.key());
+      T.params.push_back(it.value().get<ImpactParams>());
+    }
+  }
+  return T;
+}
+
+std::vector<UniverseEntry> load_universe_jsonl(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open " + path);
+  std::vector<UniverseEntry> U;
+  std::vector<std::pair<std::string, std::size_t>> seen;   // symbol, line
+  std::string line;
+  std::size_t lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    if (trim(line).empty()) continue;
+    json j = json::parse(line);
+    U.push_back({j.at("symbol").get<std::string>(),
+                 j.at("fills").get<std::string>(),
+                 j.at("mkt").get<std::string>()});
+    seen.emplace_back(U.back().symbol, lineno);
+  }
+  std::sort(seen.begin(), seen.end());
+  for (std::size_t i = 1; i < seen.size(); ++i)
+    if (seen[i].first == seen[i - 1].first)
+      throw std::runtime_error(path + ":" + std::to_string(seen[i].second) + ": duplicate symbol "
+                               + seen[i].first + " (first on line " + std::to_string(seen[i - 1].second) + ")");
+  return U;
+}
+
+std::vector<NormalEquations> panel_impact_stats(const std::vector<UniverseEntry>& U,
+                                                bool include_spread_control,
+                                                bool include_sigma_control,
+                                                unsigned threads) {
+  std::vector<NormalEquations> stats(U.size());
+  parallel_for(U.size(), threads, [&](std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; ++i) {
+      const Fills F = load_fills_csv(U[i].fills_path);
+      const Snaps M = load_snaps_csv(U[i].mkt_path);
+      stats[i] = M.empty()
+          ? NormalEquations(temp_impact_columns(include_spread_control, include_sigma_control))
+          : accumulate_temp_impact(F, M, include_spread_control, include_sigma_control);
+    }
+  });
+  return stats;
+}
+
+PanelImpactFit fit_impact_panel(const std::vector<std::string>& symbols,
+                                const std::vector<NormalEquations>& stats) {
+  if (symbols.size() != stats.size() || stats.empty())
+    throw std::invalid_argument("panel: symbols/stats size mismatch");
+  const std::size_t m = stats.size();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+
+  PanelImpactFit P;
+  NormalEquations pooled(stats.front().k());
+  for (const auto& s : stats) pooled.merge(s);
+  P.pooled = solve_normal_equations(pooled);
+
+  // Per-symbol OLS from each symbol's own sums, solved as one batch;
+  // symbols that are not estimable on their own come back NaN and fall
+  // back to the mean below.
+  P.raw_eta.assign(m, nan);
+  P.se_eta.assign(m, nan);
+  const std::vector<ImpactFit> fits = fit_temporary_impact_ols(stats);
+  for (std::size_t i = 0; i < m; ++i) {
+    const ImpactFit& f = fits[i];
+    if (std::isfinite(f.coef(1)) && std::isfinite(f.se(1)) && f.se(1) > 0.0) {
+      P.raw_eta[i] = f.coef(1) * 0.1;
+      P.se_eta[i]  = f.se(1) * 0.1;
+    }
+  }
+
+  // DerSimonian-Laird moment estimate of the between-symbol variance.
+  double sw = 0.0, sw2 = 0.0, swy = 0.0;
+  std::size_t used = 0;
+  for (std::size_t i = 0; i < m; ++i) {
+    if (!std::isfinite(P.raw_eta[i])) continue;
+    const double w = 1.0 / (P.se_eta[i] * P.se_eta[i]);
+    sw += w; sw2 += w * w; swy += w * P.raw_eta[i];
+    ++used;
+  }
+  if (used == 0) {
+    P.mu_eta = P.pooled.params.eta_bp_per_10pov;
+  } else {
+    const double mu_fe = swy / sw;
+    double q = 0.0;
+    for (std::size_t i = 0; i < m; ++i) {
+      if (!std::isfinite(P.raw_eta[i])) continue;
+      const double d = P.raw_eta[i] - mu_fe;
+      q += d * d / (P.se_eta[i] * P.se_eta[i]);
+    }
+    const double c = sw - sw2 / sw;
+    P.tau2 = (used > 1 && c > 0.0) ? std::max(0.0, (q - static_cast<double>(used - 1)) / c) : 0.0;
+
+    double sw_re = 0.0, swy_re = 0.0;
+    for (std::size_t i = 0; i < m; ++i) {
+      if (!std::isfinite(P.raw_eta[i])) continue;
+      const double w = 1.0 / (P.se_eta[i] * P.se_eta[i] + P.tau2);
+      sw_re += w; swy_re += w * P.raw_eta[i];
+    }
+    P.mu_eta = swy_re / sw_re;
+  }
+
+  P.shrink.assign(m, 1.0);
+  std::vector<std::size_t> order(m);
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return symbols[a] < symbols[b]; });
+  for (std::size_t i = 1; i < m; ++i)
+    if (symbols[order[i]] == symbols[order[i - 1]])
+      throw std::invalid_argument("panel: duplicate symbol " + symbols[order[i]]);
+
+  P.table.pooled = P.pooled.params;
+  P.table.pooled.eta_bp_per_10pov = P.mu_eta;
+  for (std::size_t i : order) {
+    ImpactParams p = P.table.pooled;
+    if (std::isfinite(P.raw_eta[i])) {
+      const double v = P.se_eta[i] * P.se_eta[i];
+      P.shrink[i] = v / (v + P.tau2);
+      p.eta_bp_per_10pov = P.shrink[i] * P.mu_eta + (1.0 - P.shrink[i]) * P.raw_eta[i];
+    }
+    P.table.symbols.push_back(symbols[i]);
+    P.table.params.push_back(p);
+  }
+  return P;
+}
+
+} // namespace tca
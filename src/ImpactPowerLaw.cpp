@@ -0,0 +1,130 @@
+#include "../include/tca/ImpactPowerLaw.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace tca {
+
+namespace {
+
+constexpr int kMaxP = 5;
+using PVec = Eigen::Matrix<double, Eigen::Dynamic, 1, 0, kMaxP, 1>;
+using PMat = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, kMaxP, kMaxP>;
+
+struct Eval {
+  PMat JtJ;
+  PVec Jtr;
+  double sse = 0.0;
+};
+
+struct Model {
+  const ImpactColumns& C;
+  std::vector<double> log_u;   // log(pov / 0.1); 0 where pov == 0
+  std::vector<double> has;     // 1 where pov > 0, else 0 (term vanishes)
+  bool sp, sg;
+  int p;
+
+  // Residuals, J'J, J'r and SSE at theta in one pass.
+  Eval evaluate(const PVec& th) const {
+    Eval E;
+    E.JtJ = PMat::Zero(p, p);
+    E.Jtr = PVec::Zero(p);
+    const double c0 = th(0), eta = th(1), beta = th(2);
+    const double csp = sp ? th(3) : 0.0;
+    const double csg = sg ? th(sp ? 4 : 3) : 0.0;
+
+    PVec J(p);
+    const std::size_t n = C.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      const double pw = has[i] * std::exp(beta * log_u[i]);
+      const double sx = C.sign[i] * pw;
+      const double r = C.y[i] - (c0 + eta * sx + csp * C.spread[i] + csg * C.sigma[i]);
+      int c = 0;
+      J(c++) = 1.0;
+      J(c++) = sx;
+      J(c++) = eta * sx * log_u[i];
+      if (sp) J(c++) = C.spread[i];
+      if (sg) J(c++) = C.sigma[i];
+      E.JtJ.noalias() += J * J.transpose();
+      E.Jtr += r * J;
+      E.sse += r * r;
+    }
+    return E;
+  }
+};
+
+} // namespace
+
+PowerLawFit fit_temporary_impact_power_law(const ImpactColumns& C, const PowerLawOptions& opt) {
+  const bool sp = opt.include_spread_control, sg = opt.include_sigma_control;
+  const int p = 3 + (sp ? 1 : 0) + (sg ? 1 : 0);
+  const std::size_t n = C.size();
+  if (n <= static_cast<std::size_t>(p)) throw std::invalid_argument("power law: need more rows than parameters");
+
+  Model m{C, std::vector<double>(n), std::vector<double>(n), sp, sg, p};
+  for (std::size_t i = 0; i < n; ++i) {
+    const bool pos = C.pov[i] > 0.0;
+    m.has[i] = pos ? 1.0 : 0.0;
+    m.log_u[i] = pos ? std::log(C.pov[i] / 0.1) : 0.0;
+  }
+
+  // Warm start: linear OLS on the same columns (beta = 1).
+  NormalEquations ne(p - 1);
+  double x[kMaxP];
+  double ysum = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    int c = 0;
+    x[c++] = 1.0;
+    x[c++] = C.sign[i] * C.pov[i];
+    if (sp) x[c++] = C.spread[i];
+    if (sg) x[c++] = C.sigma[i];
+    ne.add(x, C.y[i]);
+    ysum += C.y[i];
+  }
+  const ImpactFit lin = solve_normal_equations(ne);
+
+  PVec th(p);
+  th(0) = lin.coef(0);
+  th(1) = lin.coef(1) * 0.1;
+  th(2) = 1.0;
+  for (int c = 2; c < p - 1; ++c) th(c + 1) = lin.coef(c);
+
+  PowerLawFit out;
+  Eval cur = m.evaluate(th);
+  out.iterations = 1;
+  double mu = 1e-3;
+  for (int it = 0; it < opt.max_iter; ++it) {
+    // Marquardt-scaled damping on the diagonal.
+    PMat A = cur.JtJ;
+    for (int c = 0; c < p; ++c) A(c, c) += mu * std::max(cur.JtJ(c, c), 1e-12);
+    const PVec step = A.ldlt().solve(cur.Jtr);
+
+    PVec cand = th + step;
+    cand(2) = std::clamp(cand(2), opt.beta_min, opt.beta_max);
+    Eval trial = m.evaluate(cand);
+    ++out.iterations;
+
+    if (std::isfinite(trial.sse) && trial.sse < cur.sse) {
+      const double rel = (cur.sse - trial.sse) / std::max(cur.sse, 1e-300);
+      const double dx = (cand - th).norm() / (th.norm() + opt.tol);
+      th = cand;
+      cur = std::move(trial);
+      mu = std::max(mu / 3.0, 1e-12);
+      if (rel < opt.tol || dx < opt.tol) { out.converged = true; break; }
+    } else {
+      mu *= 4.0;
+      if (mu > 1e12) break;   // stalled: no downhill step left, not converged
+    }
+  }
+
+  const double nn = static_cast<double>(n);
+  const double sst = ne.yty - ysum * ysum / nn;
+  out.theta = th;
+  out.sse = cur.sse;
+  out.r2 = (sst > 0.0) ? 1.0 - cur.sse / sst : 0.0;
+  out.params.eta_bp_per_10pov = th(1);
+  out.params.beta = th(2);
+  return out;
+}
+
+} // namespace tca
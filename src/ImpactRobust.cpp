@@ -0,0 +1,167 @@
+#include "../include/tca/ImpactRobust.hpp"
+#include "../include/tca/Reduce.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace tca {
+
+std::string to_string(RobustLoss l) {
+  return l == RobustLoss::Tukey ? "tukey" : "huber";
+}
+
+namespace {
+
+constexpr double kMadToSigma = 0.6744897501960817;
+
+// Columns beyond k stay zero, as in the parallel OLS builder.
+struct WeightedGram {
+  Eigen::Matrix4d XtX = Eigen::Matrix4d::Zero();
+  Eigen::Vector4d Xty = Eigen::Vector4d::Zero();
+  double yty = 0.0;
+  double wsum = 0.0;
+  double objective = 0.0;
+  std::size_t downweighted = 0;
+  std::size_t rejected = 0;
+};
+
+inline void load_row(const ImpactColumns& C, std::size_t i, bool sp, bool sg, Eigen::Vector4d& x) {
+  int c = 0;
+  x(c++) = 1.0;
+  x(c++) = C.sign[i] * C.pov[i];
+  if (sp) x(c++) = C.spread[i];
+  if (sg) x(c++) = C.sigma[i];
+}
+
+// Weight and rho for u = r / (tuning * scale).
+inline void huber(double u, double& w, double& rho) {
+  const double a = std::abs(u);
+  if (a <= 1.0) { w = 1.0; rho = 0.5 * u * u; }
+  else          { w = 1.0 / a; rho = a - 0.5; }
+}
+
+inline void tukey(double u, double& w, double& rho) {
+  const double a = std::abs(u);
+  if (a < 1.0) {
+    const double t = 1.0 - u * u;
+    w = t * t;
+    rho = (1.0 - t * t * t) / 6.0;
+  } else {
+    w = 0.0; rho = 1.0 / 6.0;
+  }
+}
+
+WeightedGram weighted_pass(const ImpactColumns& C, bool sp, bool sg, const Eigen::Vector4d& b,
+                           RobustLoss loss, double cs, unsigned threads) {
+  return deterministic_reduce(C.size(), threads, WeightedGram{},
+      [&](std::size_t lo, std::size_t hi) {
+        WeightedGram P;
+        Eigen::Vector4d x = Eigen::Vector4d::Zero();
+        for (std::size_t i = lo; i < hi; ++i) {
+          load_row(C, i, sp, sg, x);
+          const double y = C.y[i];
+          const double u = (y - x.dot(b)) / cs;
+          double w, rho;
+          if (loss == RobustLoss::Tukey) tukey(u, w, rho); else huber(u, w, rho);
+          P.XtX.noalias() += (w * x) * x.transpose();
+          P.Xty += (w * y) * x;
+          P.yty += w * y * y;
+          P.wsum += w;
+          P.objective += rho;
+          P.downweighted += (w < 1.0);
+          P.rejected += (w == 0.0);
+        }
+        return P;
+      },
+      [](WeightedGram a, const WeightedGram& o) {
+        a.XtX += o.XtX; a.Xty += o.Xty; a.yty += o.yty; a.wsum += o.wsum;
+        a.objective += o.objective; a.downweighted += o.downweighted; a.rejected += o.rejected;
+        return a;
+      });
+}
+
+double median_inplace(std::vector<double>& v) {
+  const std::size_t m = v.size() / 2;
+  std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(m), v.end());
+  double med = v[m];
+  if (v.size() % 2 == 0) med = 0.5 * (med + *std::max_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(m)));
+  return med;
+}
+
+} // namespace
+
+RobustFit fit_temporary_impact_robust(const ImpactColumns& C, const RobustOptions& opt) {
+  const bool sp = opt.include_spread_control, sg = opt.include_sigma_control;
+  const int k = temp_impact_columns(sp, sg);
+  const std::size_t n = C.size();
+  if (n <= static_cast<std::size_t>(k)) throw std::invalid_argument("robust impact: need more rows than columns");
+
+  // OLS start and MAD scale from its residuals.
+  NormalEquations ne(k);
+  Eigen::Vector4d x = Eigen::Vector4d::Zero();
+  for (std::size_t i = 0; i < n; ++i) { load_row(C, i, sp, sg, x); ne.add(x.data(), C.y[i]); }
+  const ImpactFit ols = solve_normal_equations(ne);
+
+  Eigen::Vector4d b = Eigen::Vector4d::Zero();
+  b.head(k) = ols.coef;
+  std::vector<double> r(n);
+  for (std::size_t i = 0; i < n; ++i) { load_row(C, i, sp, sg, x); r[i] = C.y[i] - x.dot(b); }
+  const double med = median_inplace(r);
+  for (auto& v : r) v = std::abs(v - med);
+  const double scale = median_inplace(r) / kMadToSigma;
+  r = {};
+
+  RobustFit out;
+  out.scale = scale;
+  out.tuning = opt.tuning > 0.0 ? opt.tuning : (opt.loss == RobustLoss::Tukey ? 4.685 : 1.345);
+  out.fit = ols;
+  if (!(scale > 0.0)) { out.converged = true; return out; }   // exact fit: nothing to downweight
+
+  const double huber_cs = (opt.loss == RobustLoss::Huber ? out.tuning : 1.345) * scale;
+  const double final_cs = out.tuning * scale;
+  RobustLoss stage = RobustLoss::Huber;
+  double cs = huber_cs;
+
+  WeightedGram G;
+  for (int it = 0; it < opt.max_iter; ++it) {
+    G = weighted_pass(C, sp, sg, b, stage, cs, opt.threads);
+    ++out.iterations;
+
+    Eigen::VectorXd sol;
+    if (!solve_unaliased(G.XtX.topLeftCorner(k, k), G.Xty.head(k), ols.aliased, sol))
+      throw std::runtime_error("robust impact: weighted X'X is singular");
+    Eigen::Vector4d nb = Eigen::Vector4d::Zero();
+    nb.head(k) = sol;
+
+    const double step = ((nb - b).cwiseAbs().array() / (b.cwiseAbs().array() + 1.0)).maxCoeff();
+    out.history.push_back({step, G.objective, G.wsum});
+    b = nb;
+    if (step < opt.tol) {
+      if (stage == opt.loss) { out.converged = true; break; }
+      stage = opt.loss;          // Huber solution reached; continue with Tukey
+      cs = final_cs;
+    }
+  }
+
+  // Diagnostics at the final coefficients.
+  G = weighted_pass(C, sp, sg, b, opt.loss, final_cs, opt.threads);
+  const Eigen::MatrixXd A = G.XtX.topLeftCorner(k, k);
+  const Eigen::VectorXd coef = b.head(k);
+  const double wsse = std::max(0.0, G.yty - 2.0 * coef.dot(G.Xty.head(k)) + coef.dot(A * coef));
+  out.fit.coef = coef;
+  out.fit.n = n;
+  out.fit.sigma2 = wsse / std::max(G.wsum - static_cast<double>(k - static_cast<int>(ols.aliased.size())), 1.0);
+  Eigen::VectorXd unused;
+  Eigen::MatrixXd inv;
+  if (!solve_unaliased(A, G.Xty.head(k), ols.aliased, unused, &inv))
+    throw std::runtime_error("robust impact: weighted X'X is singular");
+  out.fit.se = (out.fit.sigma2 * inv.diagonal()).cwiseMax(0.0).cwiseSqrt();
+  for (int a : ols.aliased) out.fit.se(a) = std::numeric_limits<double>::quiet_NaN();
+  out.fit.params.eta_bp_per_10pov = coef(1) * 0.1;
+  out.downweighted = G.downweighted;
+  out.rejected = G.rejected;
+  return out;
+}
+
+} // namespace tca
@@ -0,0 +1,86 @@
+#include "../include/tca/ImpactRolling.hpp"
+#include "../include/tca/Market.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace tca {
+
+DailyImpactStats daily_impact_stats(const Fills& F,
+                                    const Snaps& M,
+                                    double day_s,
+                                    bool include_spread_control,
+                                    bool include_sigma_control) {
+  if (!(day_s > 0.0)) throw std::invalid_argument("daily_impact_stats: day_s must be > 0");
+  const int k = temp_impact_columns(include_spread_control, include_sigma_control);
+
+  DailyImpactStats S;
+  AsOfCursor cur(M);
+  double row[4];
+  for (const auto& f : F) {
+    const long long d = static_cast<long long>(std::floor(f.time / day_s));
+    if (S.day.empty() || S.day.back() != d) {
+      if (!S.day.empty() && d < S.day.back())
+        throw std::invalid_argument("daily_impact_stats: fills must be time-sorted");
+      S.day.push_back(d);
+      S.ne.emplace_back(k);
+    }
+    double y = 0.0;
+    temp_impact_row(f, cur.at(f.time), include_spread_control, include_sigma_control, row, y);
+    S.ne.back().add(row, y);
+  }
+  return S;
+}
+
+RollingImpactFitter::RollingImpactFitter(std::size_t window, std::size_t resync_every)
+  : window_(window), resync_every_(resync_every) {
+  if (window == 0) throw std::invalid_argument("RollingImpactFitter: window must be >= 1");
+}
+
+void RollingImpactFitter::push(const NormalEquations& day) {
+  if (days_.empty()) sum_ = NormalEquations(day.k());
+  if (day.k() != sum_.k()) throw std::invalid_argument("RollingImpactFitter: column count changed");
+
+  days_.push_back(day);
+  sum_.merge(day);
+  if (days_.size() > window_) {
+    const NormalEquations& old = days_.front();
+    sum_.XtX -= old.XtX;
+    sum_.Xty -= old.Xty;
+    sum_.yty -= old.yty;
+    sum_.n   -= old.n;
+    days_.pop_front();
+
+    if (resync_every_ > 0 && ++since_resync_ >= resync_every_) {
+      sum_ = NormalEquations(day.k());
+      for (const auto& d : days_) sum_.merge(d);
+      since_resync_ = 0;
+    }
+  }
+}
+
+std::vector<RollingImpactPoint> rolling_impact_fits(const DailyImpactStats& S,
+                                                    std::size_t window,
+                                                    std::size_t step) {
+  if (step == 0) throw std::invalid_argument("rolling_impact_fits: step must be >= 1");
+  std::vector<RollingImpactPoint> out;
+  RollingImpactFitter R(window);
+  std::size_t full_windows = 0;
+  for (std::size_t i = 0; i < S.ne.size(); ++i) {
+    R.push(S.ne[i]);
+    if (!R.full()) continue;
+    if (full_windows++ % step != 0) continue;
+
+    RollingImpactPoint p;
+    p.day = S.day[i];
+    try {
+      p.fit = R.fit();
+      p.ok = true;
+    } catch (const std::exception&) {
+      p.ok = false;
+    }
+    out.push_back(std::move(p));
+  }
+  return out;
+}
+
+} // namespace tca
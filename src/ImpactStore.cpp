@@ -0,0 +1,244 @@
+#include "../include/tca/ImpactStore.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tca {
+
+namespace {
+
+constexpr char kMagic[8] = {'T', 'C', 'A', 'I', 'M', 'P', 'S', '1'};
+constexpr std::uint32_t kVersion = 1;
+
+struct StoreHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t record_size;
+  std::uint64_t count;
+  std::uint64_t reserved;
+};
+static_assert(sizeof(StoreHeader) == 32, "StoreHeader layout is part of the file format");
+
+auto key_of(const ImpactRecord& r) {
+  return std::make_tuple(std::string_view(r.symbol, strnlen(r.symbol, sizeof r.symbol)),
+                         r.spec_hash, r.window_end, r.window_start);
+}
+
+bool key_less(const ImpactRecord& a, const ImpactRecord& b) { return key_of(a) < key_of(b); }
+
+void set_symbol(ImpactRecord& r, const std::string& symbol) {
+  if (symbol.empty() || symbol.size() >= sizeof r.symbol)
+    throw std::invalid_argument("impact store: symbol must be 1-31 characters");
+  std::memset(r.symbol, 0, sizeof r.symbol);
+  std::memcpy(r.symbol, symbol.data(), symbol.size());
+}
+
+// Closes the descriptor on scope exit.
+struct Fd {
+  int fd;
+  explicit Fd(int f) : fd(f) {}
+  ~Fd() { if (fd >= 0) ::close(fd); }
+  Fd(const Fd&) = delete;
+  Fd& operator=(const Fd&) = delete;
+};
+
+bool write_all(int fd, const void* data, std::size_t n) {
+  const char* p = static_cast<const char*>(data);
+  while (n > 0) {
+    const ssize_t w = ::write(fd, p, n);
+    if (w < 0) { if (errno == EINTR) continue; return false; }
+    p += w;
+    n -= static_cast<std::size_t>(w);
+  }
+  return true;
+}
+
+} // namespace
+
+std::uint64_t fingerprint_files(const std::vector<std::string>& paths) {
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  std::vector<char> buf(1 << 16);
+  for (const auto& p : paths) {
+    std::ifstream in(p, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open " + p);
+    while (in) {
+      in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+      h = fnv1a64(buf.data(), static_cast<std::size_t>(in.gcount()), h);
+    }
+    const unsigned char sep = 0xff;      // keep ("ab","c") distinct from ("a","bc")
+    h = fnv1a64(&sep, 1, h);
+  }
+  return h;
+}
+
+std::string temp_impact_spec(bool include_spread_control, bool include_sigma_control) {
+  std::string s = "temp-ols:1,pov";
+  if (include_spread_control) s += ",spread";
+  if (include_sigma_control)  s += ",sigma";
+  return s;
+}
+
+std::uint64_t spec_hash(const std::string& spec) {
+  const std::uint64_t h = fnv1a64(spec.data(), spec.size());
+  return h != 0 ? h : 1;    // 0 is the "any spec" wildcard
+}
+
+std::string temp_impact_spec_name(std::uint64_t h) {
+  for (bool sp : {true, false})
+    for (bool sg : {true, false}) {
+      std::string s = temp_impact_spec(sp, sg);
+      if (spec_hash(s) == h) return s;
+    }
+  return {};
+}
+
+ImpactParams ImpactRecord::params() const {
+  ImpactParams p;
+  p.eta_bp_per_10pov = eta_bp_per_10pov;
+  p.gamma_bp_per_10pov = gamma_bp_per_10pov;
+  p.beta = beta;
+  return p;
+}
+
+ImpactRecord make_impact_record(const std::string& symbol, std::uint64_t spec, std::uint64_t input_fp,
+                                double window_start, double window_end, const ImpactFit& fit) {
+  ImpactRecord r;
+  set_symbol(r, symbol);
+  r.spec_hash = spec;
+  r.input_fp = input_fp;
+  r.window_start = window_start;
+  r.window_end = window_end;
+  r.eta_bp_per_10pov = fit.params.eta_bp_per_10pov;
+  r.gamma_bp_per_10pov = fit.params.gamma_bp_per_10pov;
+  r.beta = fit.params.beta;
+  r.n = fit.n;
+  r.r2 = fit.r2;
+  return r;
+}
+
+ImpactStoreView::ImpactStoreView(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return;                       // no store yet
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) { ::close(fd); throw std::runtime_error("impact store: cannot stat " + path); }
+  bytes_ = static_cast<std::size_t>(st.st_size);
+  if (bytes_ < sizeof(StoreHeader)) { ::close(fd); throw std::runtime_error("impact store: truncated " + path); }
+  map_ = ::mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map_ == MAP_FAILED) { map_ = nullptr; throw std::runtime_error("impact store: cannot map " + path); }
+
+  const auto* h = static_cast<const StoreHeader*>(map_);
+  if (std::memcmp(h->magic, kMagic, sizeof kMagic) != 0 || h->version != kVersion ||
+      h->record_size != sizeof(ImpactRecord) ||
+      bytes_ != sizeof(StoreHeader) + h->count * sizeof(ImpactRecord)) {
+    ::munmap(map_, bytes_);
+    map_ = nullptr;
+    throw std::runtime_error("impact store: bad header in " + path);
+  }
+  recs_ = reinterpret_cast<const ImpactRecord*>(static_cast<const char*>(map_) + sizeof(StoreHeader));
+  count_ = static_cast<std::size_t>(h->count);
+}
+
+ImpactStoreView::~ImpactStoreView() {
+  if (map_) ::munmap(map_, bytes_);
+}
+
+const ImpactRecord* ImpactStoreView::find(const std::string& symbol, std::uint64_t spec,
+                                          double window_start, double window_end) const {
+  ImpactRecord probe;
+  set_symbol(probe, symbol);
+  probe.spec_hash = spec;
+  probe.window_start = window_start;
+  probe.window_end = window_end;
+  const ImpactRecord* it = std::lower_bound(begin(), end(), probe, key_less);
+  return (it != end() && key_of(*it) == key_of(probe)) ? it : nullptr;
+}
+
+std::pair<const ImpactRecord*, const ImpactRecord*>
+ImpactStoreView::symbol_range(const std::string& symbol) const {
+  const std::string_view sym(symbol);
+  auto sym_of = [](const ImpactRecord& r) { return std::string_view(r.symbol, strnlen(r.symbol, sizeof r.symbol)); };
+  const ImpactRecord* lo = std::lower_bound(begin(), end(), sym,
+      [&](const ImpactRecord& r, std::string_view s) { return sym_of(r) < s; });
+  const ImpactRecord* hi = std::upper_bound(lo, end(), sym,
+      [&](std::string_view s, const ImpactRecord& r) { return s < sym_of(r); });
+  return {lo, hi};
+}
+
+const ImpactRecord* ImpactStoreView::find_input(const std::string& symbol, std::uint64_t spec,
+                                                std::uint64_t fp) const {
+  const auto [lo, hi] = symbol_range(symbol);
+  const ImpactRecord* best = nullptr;
+  for (const ImpactRecord* r = lo; r != hi; ++r)
+    if (r->spec_hash == spec && r->input_fp == fp && (!best || r->window_end > best->window_end)) best = r;
+  return best;
+}
+
+const ImpactRecord* ImpactStoreView::latest(const std::string& symbol, std::uint64_t spec) const {
+  const auto [lo, hi] = symbol_range(symbol);
+  const ImpactRecord* best = nullptr;
+  for (const ImpactRecord* r = lo; r != hi; ++r)
+    if ((spec == 0 || r->spec_hash == spec) && (!best || r->window_end > best->window_end)) best = r;
+  return best;
+}
+
+void upsert_impact_store(const std::string& path, const ImpactRecord& rec) {
+  // Writers serialize on a sidecar lock file: the store itself is replaced by
+  // rename, so a lock on its inode would not exclude a writer that opened
+  // the new file.
+  const Fd lock(::open((path + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+  if (lock.fd < 0) throw std::runtime_error("impact store: cannot open " + path + ".lock");
+  while (::flock(lock.fd, LOCK_EX) != 0)
+    if (errno != EINTR) throw std::runtime_error("impact store: cannot lock " + path);
+
+  std::vector<ImpactRecord> recs;
+  {
+    ImpactStoreView v(path);
+    recs.assign(v.begin(), v.end());
+  }
+  auto it = std::lower_bound(recs.begin(), recs.end(), rec, key_less);
+  if (it != recs.end() && key_of(*it) == key_of(rec)) *it = rec;
+  else recs.insert(it, rec);
+
+  StoreHeader h{};
+  std::memcpy(h.magic, kMagic, sizeof kMagic);
+  h.version = kVersion;
+  h.record_size = sizeof(ImpactRecord);
+  h.count = recs.size();
+
+  // Unique temporary in the store's directory, so rename stays atomic and
+  // concurrent writers never share it; fsync before rename so a crash
+  // leaves either the old store or the complete new one.
+  const std::size_t slash = path.find_last_of('/');
+  const std::string dir = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+  std::string tmp = path + ".XXXXXX";
+  {
+    const Fd out(::mkstemp(tmp.data()));
+    if (out.fd < 0) throw std::runtime_error("impact store: cannot create temporary for " + path);
+    if (!write_all(out.fd, &h, sizeof h) ||
+        !write_all(out.fd, recs.data(), recs.size() * sizeof(ImpactRecord)) ||
+        ::fchmod(out.fd, 0644) != 0 || ::fsync(out.fd) != 0) {
+      ::unlink(tmp.c_str());
+      throw std::runtime_error("impact store: cannot write " + tmp);
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    ::unlink(tmp.c_str());
+    throw std::runtime_error("impact store: cannot replace " + path);
+  }
+  const Fd d(::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+  if (d.fd < 0 || ::fsync(d.fd) != 0)
+    throw std::runtime_error("impact store: cannot sync directory of " + path);
+}
+
+} // namespace tca
@@ -0,0 +1,105 @@
+#include "../include/tca/ImpactVenue.hpp"
+#include "../include/tca/Market.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace tca {
+
+VenueImpactStats accumulate_venue_impact(const Fills& F,
+                                         const Snaps& M,
+                                         bool include_spread_control,
+                                         bool include_sigma_control) {
+  const int k = temp_impact_columns(include_spread_control, include_sigma_control);
+  const int p = k - 1;
+
+  VenueImpactStats S;
+  S.ne = NormalEquations(p);
+  std::unordered_map<std::string, std::size_t> ids;
+  std::vector<double> sx;   // p * V, grown as venues appear
+  std::vector<double> sy;
+
+  AsOfCursor cur(M);
+  double row[4];
+  for (const auto& f : F) {
+    auto [it, fresh] = ids.try_emplace(f.venue, S.venues.size());
+    if (fresh) {
+      S.venues.push_back(f.venue);
+      S.n.push_back(0);
+      sx.resize(sx.size() + p, 0.0);
+      sy.push_back(0.0);
+    }
+    const std::size_t v = it->second;
+
+    double y = 0.0;
+    temp_impact_row(f, cur.at(f.time), include_spread_control, include_sigma_control, row, y);
+    const double* x = row + 1;   // drop the intercept; venues absorb it
+    S.ne.add(x, y);
+    ++S.n[v];
+    for (int c = 0; c < p; ++c) sx[v * p + c] += x[c];
+    sy[v] += y;
+  }
+
+  const auto V = static_cast<Eigen::Index>(S.venues.size());
+  S.sx = Eigen::Map<const Eigen::MatrixXd>(sx.data(), p, V);
+  S.sy = Eigen::Map<const Eigen::VectorXd>(sy.data(), V);
+  return S;
+}
+
+VenueImpactFit fit_venue_impact(const VenueImpactStats& S) {
+  const Eigen::Index p = S.ne.k();
+  const std::size_t V = S.venues.size();
+  if (p < 1 || V == 0 || S.ne.n <= V + static_cast<std::size_t>(p))
+    throw std::invalid_argument("venue impact: need n > venues + slopes");
+
+  // Within transformation applied to the sums.
+  Eigen::MatrixXd W = S.ne.XtX;
+  Eigen::VectorXd Wy = S.ne.Xty;
+  double wyy = S.ne.yty;
+  for (std::size_t v = 0; v < V; ++v) {
+    const double nv = static_cast<double>(S.n[v]);
+    const auto sxv = S.sx.col(static_cast<Eigen::Index>(v));
+    const double syv = S.sy(static_cast<Eigen::Index>(v));
+    W.noalias() -= sxv * sxv.transpose() / nv;
+    Wy -= sxv * (syv / nv);
+    wyy -= syv * syv / nv;
+  }
+
+  VenueImpactFit fit;
+  fit.n = S.ne.n;
+  fit.aliased = aliased_columns(W);
+  Eigen::MatrixXd Winv;
+  if ((!fit.aliased.empty() && fit.aliased.front() == 0) ||
+      !solve_unaliased(W, Wy, fit.aliased, fit.coef, &Winv))
+    throw std::runtime_error("venue impact: within X'X is singular (POV aliased)");
+  const double sse = std::max(0.0, wyy - fit.coef.dot(Wy));
+  const double dof = static_cast<double>(S.ne.n - V - static_cast<std::size_t>(p) + fit.aliased.size());
+  fit.sigma2 = sse / dof;
+  fit.r2_within = (wyy > 0.0) ? 1.0 - sse / wyy : 0.0;
+
+  fit.se = (fit.sigma2 * Winv.diagonal()).cwiseMax(0.0).cwiseSqrt();
+  for (int a : fit.aliased) fit.se(a) = std::numeric_limits<double>::quiet_NaN();
+  fit.params.eta_bp_per_10pov = fit.coef(0) * 0.1;
+
+  std::vector<std::size_t> order(V);
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::sort(order.begin(), order.end(),
+            [&](std::size_t a, std::size_t b) { return S.venues[a] < S.venues[b]; });
+  fit.venues.reserve(V);
+  for (std::size_t v : order) {
+    const double nv = static_cast<double>(S.n[v]);
+    const Eigen::VectorXd xbar = S.sx.col(static_cast<Eigen::Index>(v)) / nv;
+    VenueIntercept a;
+    a.venue = S.venues[v];
+    a.n = S.n[v];
+    a.alpha = S.sy(static_cast<Eigen::Index>(v)) / nv - xbar.dot(fit.coef);
+    a.se = std::sqrt(std::max(0.0, fit.sigma2 * (1.0 / nv + xbar.dot(Winv * xbar))));
+    fit.venues.push_back(std::move(a));
+  }
+  return fit;
+}
+
+} // namespace tca
@@ -1,4 +1,5 @@
 #include "../include/tca/Optimize.hpp"
+#include "../include/tca/ScheduleQP.hpp"
 #include <algorithm>
 #include <numeric>
 #include <cmath>
@@ -7,47 +8,69 @@
 namespace tca {
     static inline int side_sign(Side s) { return (s == Side::BUY) ? +1 : -1; }
 
-    static inline double cap_for_slice(double max_pov, double vol_est) {
+    double cap_for_slice(double max_pov, double vol_est) {
         if (max_pov <= 0.0 || vol_est <= 0.0) return 0.0;
         return max_pov * vol_est; 
     }
 
-    static bool enforce_caps_and_completion(std::vector<double>& x, double Q, const std::vector<double>& caps)
+    ProjectionStatus project_capped_simplex(std::span<double> x,
+                                            std::span<const double> caps,
+                                            double Q,
+                                            std::span<double> scratch)
     {
-        const int n = static_cast<int>(x.size());
-        const int sgn = (Q >= 0.0) ? +1 : -1;
-        for (int i = 0; i < n; ++i) {
-            double xi_abs = std::min(std::abs(x[i]), caps[i]);
-            x[i] = sgn * std::max(0.0, xi_abs); 
+        const std::size_t n = x.size();
+        if (caps.size() != n) throw std::invalid_argument("projection: caps size must equal x size");
+        if (scratch.size() < 2 * n) throw std::invalid_argument("projection: scratch must hold 2n doubles");
+        if (!(Q >= 0.0)) throw std::invalid_argument("projection: Q must be >= 0");
+
+        double cap_sum = 0.0;
+        for (double c : caps) {
+            if (!(c >= 0.0)) throw std::invalid_argument("projection: caps must be >= 0");
+            cap_sum += c;
         }
-
-        double sum = std::accumulate(x.begin(), x.end(), 0.0);
-        auto almost_eq = [](double a, double b) { return std::abs(a - b) <= 1e-9 * (1.0 + std::abs(b)); };
-        if (almost_eq(sum, std::abs(Q))) return true;
-
-        if (sum > std::abs(Q)) {
-            double scale = (sum > 0.0) ? (std::abs(Q) / sum) : 0.0;
-            for (int i = 0; i < n; ++i) x[i] *= scale;
-            return true; 
+        if (n == 0) return Q > 0.0 ? ProjectionStatus::Infeasible : ProjectionStatus::Ok;
+        if (Q >= cap_sum) {
+            std::copy(caps.begin(), caps.end(), x.begin());
+            const bool exact = Q - cap_sum <= 1e-9 * (1.0 + Q);
+            return exact ? ProjectionStatus::Ok : ProjectionStatus::Infeasible;
         }
 
-        for (int iter = 0; iter < 4; ++iter) { 
-            double need = std::abs(Q) - std::accumulate(x.begin(), x.end(), 0.0);
-            if (need <= 1e-9) return true;
-
-            std::vector<double> head(n);
-            for (int i = 0; i < n; ++i) head[i] = std::max(0.0, caps[i] - x[i]);
+        // Breakpoints: x_i leaves its cap at theta = y_i - c_i and hits 0 at y_i.
+        auto lo = scratch.first(n);
+        auto hi = scratch.subspan(n, n);
+        for (std::size_t i = 0; i < n; ++i) { lo[i] = x[i] - caps[i]; hi[i] = x[i]; }
+        std::sort(lo.begin(), lo.end());
+        std::sort(hi.begin(), hi.end());
+
+        // Sweep theta upward from lo[0], where every x_i sits at its cap; the
+        // sum falls with slope -(number of coordinates strictly inside).
+        double theta = lo[0], g = cap_sum;
+        std::size_t i = 0, j = 0, active = 0;
+        while (g > Q && j < n) {
+            const bool enter = i < n && lo[i] <= hi[j];
+            const double next = enter ? lo[i] : hi[j];
+            const double g_next = g - static_cast<double>(active) * (next - theta);
+            if (g_next <= Q) { theta += (g - Q) / static_cast<double>(active); break; }
+            g = g_next;
+            theta = next;
+            if (enter) { ++active; ++i; } else { --active; ++j; }
+        }
 
-            double head_sum = std::accumulate(head.begin(), head.end(), 0.0);
-            if (head_sum <= 1e-12) break; 
+        for (std::size_t k = 0; k < n; ++k) x[k] = std::clamp(x[k] - theta, 0.0, caps[k]);
+        return ProjectionStatus::Ok;
+    }
 
-            for (int i = 0; i < n; ++i) {
-            double add = need * (head[i] / head_sum);
-            x[i] = std::min(caps[i], x[i] + add);
-            }
-        }
-        double filled = std::accumulate(x.begin(), x.end(), 0.0);
-        return std::abs(filled - std::abs(Q)) <= 1e-6 * (1.0 + std::abs(Q));
+    // Project a signed schedule onto its caps and record feasibility.
+    static void project_schedule(Schedule& sch, double qty, const std::vector<double>& caps)
+    {
+        const double sgn = (qty >= 0.0) ? 1.0 : -1.0;
+        const double Q = std::abs(qty);
+        for (double& v : sch.x) v = std::abs(v);
+        std::vector<double> scratch(2 * sch.x.size());
+        sch.feasible = project_capped_simplex(sch.x, caps, Q, scratch) == ProjectionStatus::Ok;
+        double filled = 0.0;
+        for (double& v : sch.x) { filled += v; v *= sgn; }
+        sch.shortfall = sch.feasible ? 0.0 : Q - filled;
     }
 
     static std::vector<double> build_caps(const OrderSpec& spec, const Snaps& forecast)
@@ -77,10 +100,9 @@ namespace tca {
         std::vector<double> x(n, std::abs(spec.qty) / std::max(1, n));
         for (double& xi : x) xi = sgn * xi;
 
-        auto caps = build_caps(spec, forecast);
-        bool ok = enforce_caps_and_completion(x, sgn * std::abs(spec.qty), caps);
         Schedule sch;
         sch.x = std::move(x);
+        project_schedule(sch, sgn * std::abs(spec.qty), build_caps(spec, forecast));
         return sch;
     }
 
@@ -102,61 +124,134 @@ namespace tca {
         }
         for (double& xi : x) xi = sgn * xi;
 
-        auto caps = build_caps(spec, forecast);
-        (void)enforce_caps_and_completion(x, sgn * std::abs(spec.qty), caps);
-
         Schedule sch;
         sch.x = std::move(x);
+        project_schedule(sch, sgn * std::abs(spec.qty), build_caps(spec, forecast));
         return sch;
     }
 
 
-    Schedule optimize_schedule(const OrderSpec& spec, const Snaps& forecast, const ImpactParams& impact)
+    double slice_seconds(const OrderSpec& spec, const Snaps& forecast)
     {
-        validate_inputs(spec, forecast);
-        const int n   = spec.slices;
-        const int sgn = side_sign(spec.side);
+        const std::size_t n = forecast.size();
+        if (spec.horizon_s > 0.0 && spec.slices > 0) return spec.horizon_s / spec.slices;
+        if (n > 1 && forecast[1].time > forecast[0].time) return forecast[1].time - forecast[0].time;
+        return 1.0;
+    }
 
-        bool any_vol = false;
-        for (const auto& s : forecast) if (s.volume > 0.0) { any_vol = true; break; }
-        if (!any_vol) return twap_schedule(spec, forecast);
+    double sigma_bps_per_sqrt_s(double sigma_annual) {
+        return std::max(0.0, sigma_annual) * 1e4 / std::sqrt(252.0 * 6.5 * 3600.0);
+    }
 
-        const double eta10 = std::max(0.0, impact.eta_bp_per_10pov); 
-        const double A = 1.0;    
-        const double B = 10.0;   
-        const double C = spec.risk_lambda;
-        const double EPS = 1e-9;
+    // sinh(a) / sinh(b) for 0 <= a <= b without overflow for large arguments.
+    static inline double sinh_ratio(double a, double b) {
+        if (b <= 0.0) return 0.0;
+        return std::exp(a - b) * (std::expm1(-2.0 * a) / std::expm1(-2.0 * b));
+    }
 
-        std::vector<double> score(n, 0.0);
-        for (int i = 0; i < n; ++i) {
-            const double V = std::max(0.0, forecast[i].volume);
-            const double sprbp = std::max(0.0, forecast[i].spread_bps);
-            const double sig = std::max(0.0, forecast[i].sigma);
+    ScheduleCost evaluate_schedule(const OrderSpec& spec, const Snaps& forecast,
+                                   const ImpactParams& impact, const Schedule& schedule)
+    {
+        validate_inputs(spec, forecast);
+        if (schedule.x.size() != forecast.size())
+            throw std::invalid_argument("schedule size must equal forecast size");
+        const double X = std::abs(spec.qty);
+        const double tau = slice_seconds(spec, forecast);
+        const double eta10 = std::max(0.0, impact.eta_bp_per_10pov);
+        const double gamma10 = std::max(0.0, impact.gamma_bp_per_10pov);
+
+        // Fractions of the order; holdings after each slice.
+        ScheduleCost c;
+        double held = 1.0, vbar = 0.0, sum_f2 = 0.0;
+        int nv = 0;
+        for (const auto& s : forecast) if (s.volume > 0.0) { vbar += s.volume; ++nv; }
+        vbar = nv > 0 ? vbar / nv : 0.0;
+        for (std::size_t j = 0; j < forecast.size(); ++j) {
+            const double f = std::abs(schedule.x[j]) / X;
+            const double V = forecast[j].volume;
+            if (f > 0.0) {
+                if (V <= 0.0) throw std::invalid_argument("schedule trades in a slice with no forecast volume");
+                c.expected_cost_bps += f * (0.5 * std::max(0.0, forecast[j].spread_bps) + 10.0 * eta10 * X * f / V);
+            }
+            sum_f2 += f * f;
+            held -= f;
+            const double sg = sigma_bps_per_sqrt_s(forecast[j].sigma);
+            c.variance_bps2 += sg * sg * tau * held * held;
+        }
+        // Permanent impact on the remaining holdings: gamma * (1/2 - sum f^2 / 2).
+        if (vbar > 0.0) c.expected_cost_bps += 10.0 * gamma10 * X / vbar * 0.5 * (1.0 - sum_f2);
+        return c;
+    }
 
-            const double impact_proxy = (eta10 / 10.0) / std::max(1.0, V);
+    ACSolution almgren_chriss_schedule(const OrderSpec& spec, const Snaps& forecast, const ImpactParams& impact)
+    {
+        validate_inputs(spec, forecast);
+        const int n   = spec.slices;
+        const int sgn = side_sign(spec.side);
+        const double X = std::abs(spec.qty);
 
-            const double denom = A * sprbp + B * impact_proxy + C * sig + EPS;
-            score[i] = (V > 0.0) ? (V / denom) : 0.0;
+        double vbar = 0.0, sbar = 0.0;
+        int nv = 0;
+        for (const auto& s : forecast) {
+            if (s.volume > 0.0) { vbar += s.volume; ++nv; }
+            sbar += std::max(0.0, s.sigma);
+        }
+        ACSolution sol;
+        if (nv == 0) {
+            sol.schedule = twap_schedule(spec, forecast);
+            return sol;
+        }
+        vbar /= nv;
+        sbar /= n;
+
+        // Model in order fractions and bps: eta_ac / tau is the temporary cost
+        // of trading the whole order in one slice, gamma_ac its permanent move.
+        const double tau = slice_seconds(spec, forecast);
+        const double T = tau * n;
+        const double eta_ac = tau * 10.0 * std::max(0.0, impact.eta_bp_per_10pov) * X / vbar;
+        const double gamma_ac = 10.0 * std::max(0.0, impact.gamma_bp_per_10pov) * X / vbar;
+        const double eta_tilde = eta_ac - 0.5 * gamma_ac * tau;
+        const double sigma = sigma_bps_per_sqrt_s(sbar);
+        const double lambda = std::max(0.0, spec.risk_lambda);
+
+        // cosh(kappa tau) = 1 + kt^2 tau^2 / 2  <=>  kappa tau = 2 asinh(kt tau / 2).
+        if (eta_tilde > 0.0 && lambda > 0.0 && sigma > 0.0) {
+            const double kt = std::sqrt(lambda * sigma * sigma / eta_tilde);
+            sol.kappa = 2.0 * std::asinh(0.5 * kt * tau) / tau;
         }
 
-        double sc_sum = std::accumulate(score.begin(), score.end(), 0.0);
         std::vector<double> x(n, 0.0);
-        if (sc_sum <= 0.0) {
-            x.assign(n, std::abs(spec.qty) / std::max(1, n));
-        } else {
-            for (int i = 0; i < n; ++i) x[i] = std::abs(spec.qty) * (score[i] / sc_sum);
+        double prev = 1.0;
+        for (int j = 1; j <= n; ++j) {
+            const double left = (sol.kappa * T > 1e-12)
+                ? sinh_ratio(sol.kappa * (T - j * tau), sol.kappa * T)
+                : 1.0 - static_cast<double>(j) / n;
+            x[j - 1] = sgn * X * (prev - left);
+            prev = left;
         }
 
-        for (double& xi : x) xi = sgn * xi;
-
-        auto caps = build_caps(spec, forecast);
-        bool ok = enforce_caps_and_completion(x, sgn * std::abs(spec.qty), caps);
+        sol.schedule.x = std::move(x);
+        project_schedule(sol.schedule, sgn * X, build_caps(spec, forecast));
+        sol.cost = evaluate_schedule(spec, forecast, impact, sol.schedule);
+        return sol;
+    }
 
-        (void)ok;
+    bool pov_bounds_bind(const OrderSpec& spec, const Snaps& forecast, const ACSolution& ac)
+    {
+        if (spec.min_pov > 0.0 || !ac.schedule.feasible) return true;
+        for (std::size_t j = 0; j < forecast.size() && j < ac.schedule.x.size(); ++j) {
+            const double cap = cap_for_slice(spec.max_pov, forecast[j].volume);
+            if (cap == 0.0) continue;    // zero-volume slice: forced to 0, not a binding cap
+            if (std::abs(ac.schedule.x[j]) >= cap * (1.0 - 1e-9)) return true;
+        }
+        return false;
+    }
 
-        Schedule sch;
-        sch.x = std::move(x);
-        return sch;
+    Schedule optimize_schedule(const OrderSpec& spec, const Snaps& forecast, const ImpactParams& impact)
+    {
+        ACSolution ac = almgren_chriss_schedule(spec, forecast, impact);
+        if (!pov_bounds_bind(spec, forecast, ac)) return std::move(ac.schedule);
+        return optimize_schedule_qp(spec, forecast, impact).schedule;
     }
 
 } 
@@ -0,0 +1,247 @@
+#include "../include/tca/OptimizeBatch.hpp"
+#include "../include/tca/IO.hpp"
+#include "../include/tca/Parallel.hpp"
+#include "../include/tca/utils.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+namespace tca {
+
+using nlohmann::json;
+
+OrderSpec order_spec_from_json(const json& j) {
+  OrderSpec spec;
+  spec.side = (j.value("side", "BUY") == "SELL") ? Side::SELL : Side::BUY;
+  spec.qty = j.at("qty").get<double>();
+  spec.horizon_s = j.value("horizon_s", 0.0);
+  spec.slices = j.at("slices").get<int>();
+  spec.max_pov = j.value("max_pov", 1.0);
+  spec.min_pov = j.value("min_pov", 0.0);
+  spec.risk_lambda = j.value("risk_lambda", 0.0);
+  if (spec.slices <= 0) throw std::runtime_error("slices must be > 0");
+  return spec;
+}
+
+std::vector<BatchOrder> load_orders_jsonl(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open " + path);
+  std::vector<BatchOrder> orders;
+  std::string line;
+  std::size_t lineno = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    if (trim(line).empty()) continue;
+    BatchOrder o;
+    o.id = std::to_string(orders.size());
+    o.start_ts = std::numeric_limits<double>::quiet_NaN();
+    try {
+      json j = json::parse(line);
+      if (j.contains("id"))
+        o.id = j.at("id").is_string() ? j.at("id").get<std::string>() : j.at("id").dump();
+      o.symbol = j.at("symbol").get<std::string>();
+      o.spec = order_spec_from_json(j);
+      if (j.contains("start_ts")) o.start_ts = j.at("start_ts").get<double>();
+    } catch (const std::exception& ex) {
+      o.error = path + ":" + std::to_string(lineno) + ": " + ex.what();
+    }
+    orders.push_back(std::move(o));
+  }
+  return orders;
+}
+
+std::size_t BatchMarket::find(const std::string& symbol) const {
+  auto it = std::lower_bound(symbols.begin(), symbols.end(), symbol);
+  if (it == symbols.end() || *it != symbol) return symbols.size();
+  return static_cast<std::size_t>(it - symbols.begin());
+}
+
+BatchMarket load_batch_forecasts(const std::vector<BatchOrder>& orders,
+                                 const std::string& mkt_dir,
+                                 unsigned threads) {
+  BatchMarket M;
+  for (const auto& o : orders)
+    if (o.error.empty()) M.symbols.push_back(o.symbol);
+  std::sort(M.symbols.begin(), M.symbols.end());
+  M.symbols.erase(std::unique(M.symbols.begin(), M.symbols.end()), M.symbols.end());
+  const std::size_t n = M.symbols.size();
+  M.forecasts.resize(n);
+  M.impact.resize(n);
+  M.error.resize(n);
+  parallel_for_stealing(n, threads, 1, [&](unsigned, std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; ++i) {
+      try { M.forecasts[i] = load_snaps_csv(mkt_dir + "/" + M.symbols[i] + ".csv"); }
+      catch (const std::exception& ex) { M.error[i] = ex.what(); }
+    }
+  });
+  return M;
+}
+
+namespace {
+
+// Length of row r: the gap to the next row, or the previous gap for the last.
+double row_step(const Snaps& f, std::size_t r) {
+  if (r + 1 < f.size()) return f[r + 1].time - f[r].time;
+  return r > 0 ? f[r].time - f[r - 1].time : 0.0;
+}
+
+// Time t in row units: r plus the fraction of row r elapsed.
+double row_pos(const Snaps& f, double t) {
+  auto it = std::upper_bound(f.begin(), f.end(), t, [](double v, const Snap& s) { return v < s.time; });
+  const std::size_t r = it == f.begin() ? 0 : static_cast<std::size_t>(it - f.begin()) - 1;
+  const double step = row_step(f, r);
+  return static_cast<double>(r) + (step > 0.0 ? (t - f[r].time) / step : 0.0);
+}
+
+} // namespace
+
+void resample_forecast(const Snaps& forecast, double t0, double t1, int slices, Snaps& out) {
+  const std::size_t R = forecast.size();
+  const std::size_t S = slices > 0 ? static_cast<std::size_t>(slices) : 0;
+  if (R == 0) { out.clear(); return; }
+  const double span0 = forecast.front().time;
+  const double span1 = forecast.back().time + row_step(forecast, R - 1);
+  const double eps = 1e-9 * std::max(1.0, std::abs(span1));
+  if (std::isinf(t1)) t1 = span1;
+  if (!(t1 > t0) || t0 < span0 - eps || t1 > span1 + eps)
+    throw std::runtime_error("order window [" + std::to_string(t0) + ", " + std::to_string(t1)
+                             + ") is outside the forecast span [" + std::to_string(span0) + ", "
+                             + std::to_string(span1) + ")");
+  const double p0 = std::max(0.0, row_pos(forecast, t0));
+  const double p1 = std::min(static_cast<double>(R), t1 >= span1 - eps ? static_cast<double>(R) : row_pos(forecast, t1));
+  if (R == S && p0 == 0.0 && p1 == static_cast<double>(R)) { out = forecast; return; }
+  out.resize(S);
+  const double w = (p1 - p0) / static_cast<double>(S);   // rows per bucket
+  for (std::size_t k = 0; k < S; ++k) {
+    const double lo = p0 + w * static_cast<double>(k), hi = lo + w;
+    const std::size_t r0 = std::min(static_cast<std::size_t>(lo), R - 1);
+    Snap s = forecast[r0];
+    s.time = t0 + (t1 - t0) * static_cast<double>(k) / static_cast<double>(S);
+    double vol = 0.0, spread = 0.0, sigma = 0.0, wsum = 0.0;
+    for (std::size_t r = r0; r < R && static_cast<double>(r) < hi; ++r) {
+      const double ov = std::min(hi, static_cast<double>(r + 1)) - std::max(lo, static_cast<double>(r));
+      if (ov <= 0.0) continue;
+      vol += ov * forecast[r].volume;
+      spread += ov * forecast[r].spread_bps;
+      sigma += ov * forecast[r].sigma;
+      wsum += ov;
+    }
+    s.volume = vol;
+    if (wsum > 0.0) { s.spread_bps = spread / wsum; s.sigma = sigma / wsum; }
+    out[k] = s;
+  }
+}
+
+namespace {
+
+// Filled by the worker that owns the order; `done` is set under the output
+// mutex, which publishes the rest to whichever thread flushes it.
+struct Slot {
+  std::string text;       // CSV rows, or the error message when failed
+  std::size_t rows = 0;
+  bool infeasible = false;
+  bool failed = false;
+  bool done = false;
+};
+
+struct Scratch {
+  ScheduleQPWorkspace qp;
+  Snaps forecast;
+  Schedule schedule;
+};
+
+void append_row(std::string& s, const std::string& id, const std::string& sym, std::size_t j, double x) {
+  char buf[64];
+  s += id; s += ','; s += sym; s += ',';
+  auto r = std::to_chars(buf, buf + sizeof buf, j);
+  s.append(buf, r.ptr);
+  s += ',';
+  r = std::to_chars(buf, buf + sizeof buf, x);
+  s.append(buf, r.ptr);
+  s += '\n';
+}
+
+void schedule_one(const BatchOrder& o, const BatchMarket& market, const BatchOptions& opt,
+                  Scratch& sc, Slot& slot) {
+  if (!o.error.empty()) throw std::runtime_error(o.error);
+  const std::size_t k = market.find(o.symbol);
+  if (k == market.symbols.size()) throw std::runtime_error("unknown symbol " + o.symbol);
+  if (!market.error[k].empty()) throw std::runtime_error(market.error[k]);
+  if (market.forecasts[k].empty()) throw std::runtime_error("no forecast for " + o.symbol);
+  // The order's window [start_ts, start_ts + horizon_s); without a horizon
+  // it runs to the end of the forecast.
+  const Snaps& f = market.forecasts[k];
+  const double t0 = std::isnan(o.start_ts) ? f.front().time : o.start_ts;
+  const double t1 = o.spec.horizon_s > 0.0 ? t0 + o.spec.horizon_s : std::numeric_limits<double>::infinity();
+  resample_forecast(f, t0, t1, o.spec.slices, sc.forecast);
+  // optimize_schedule's choice, with the worker's QP workspace.
+  ACSolution ac;
+  if (!opt.qp) ac = almgren_chriss_schedule(o.spec, sc.forecast, market.impact[k]);
+  if (opt.qp || pov_bounds_bind(o.spec, sc.forecast, ac)) {
+    auto r = optimize_schedule_qp(o.spec, sc.forecast, market.impact[k], opt.qp_opt, sc.qp);
+    sc.schedule = std::move(r.schedule);
+  } else {
+    sc.schedule = std::move(ac.schedule);
+  }
+  for (std::size_t j = 0; j < sc.schedule.x.size(); ++j)
+    append_row(slot.text, o.id, o.symbol, j, sc.schedule.x[j]);
+  slot.rows = sc.schedule.x.size();
+  slot.infeasible = !sc.schedule.feasible;
+}
+
+} // namespace
+
+BatchSummary optimize_batch(const std::vector<BatchOrder>& orders,
+                            const BatchMarket& market,
+                            const BatchOptions& opt,
+                            std::ostream& out,
+                            std::ostream& errors) {
+  BatchSummary sum;
+  sum.orders = orders.size();
+  out << "order,symbol,slice,shares\n";
+  if (orders.empty()) return sum;
+
+  std::vector<Slot> slots(orders.size());
+  std::vector<Scratch> scratch(std::min<std::size_t>(resolve_threads(opt.threads), orders.size()));
+  std::mutex out_mu;
+  std::size_t next = 0;   // first order not yet flushed (guarded by out_mu)
+
+  parallel_for_stealing(orders.size(), opt.threads, opt.grain,
+                        [&](unsigned t, std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; ++i) {
+      try {
+        schedule_one(orders[i], market, opt, scratch[t], slots[i]);
+      } catch (const std::exception& ex) {
+        slots[i].text = ex.what();
+        slots[i].failed = true;
+      }
+    }
+    // Flush the in-order prefix; whoever completes the gap writes it.
+    std::lock_guard<std::mutex> lk(out_mu);
+    for (std::size_t i = b; i < e; ++i) slots[i].done = true;
+    while (next < slots.size() && slots[next].done) {
+      Slot& s = slots[next];
+      if (!s.failed) {
+        out << s.text;
+        ++sum.written;
+        sum.rows += s.rows;
+        if (s.infeasible) ++sum.infeasible;
+      } else {
+        errors << "order " << orders[next].id << ": " << s.text << "\n";
+        ++sum.failed;
+      }
+      std::string().swap(s.text);
+      ++next;
+    }
+  });
+  if (!out) throw std::runtime_error("optimize_batch: write failed");
+  return sum;
+}
+
+} // namespace tca
@@ -0,0 +1,241 @@
+#include "../include/tca/Propagator.hpp"
+#include "../include/tca/Market.hpp"
+#include "../include/tca/Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <fstream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+namespace tca {
+
+using json = nlohmann::json;
+
+double PropagatorKernel::at(double lag_s) const {
+  if (kind == KernelKind::Exponential) return std::exp(-lag_s / tau_s);
+  return std::pow(1.0 + lag_s / l0_s, -beta);
+}
+
+std::string to_string(KernelKind k) {
+  return k == KernelKind::PowerLaw ? "power" : "exp";
+}
+
+namespace {
+
+constexpr std::size_t kDirectMax = 64;   // below this a direct sum beats the FFT
+
+// In-place iterative radix-2 FFT; a.size() must be a power of two.
+void fft(std::vector<std::complex<double>>& a, bool inverse) {
+  const std::size_t n = a.size();
+  for (std::size_t i = 1, j = 0; i < n; ++i) {
+    std::size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(a[i], a[j]);
+  }
+  const double pi = std::acos(-1.0);
+  for (std::size_t len = 2; len <= n; len <<= 1) {
+    const double ang = 2.0 * pi / static_cast<double>(len) * (inverse ? 1.0 : -1.0);
+    const std::complex<double> wl(std::cos(ang), std::sin(ang));
+    for (std::size_t i = 0; i < n; i += len) {
+      std::complex<double> w(1.0, 0.0);
+      for (std::size_t k = 0; k < len / 2; ++k) {
+        const auto x = a[i + k], y = a[i + k + len / 2] * w;
+        a[i + k] = x + y;
+        a[i + k + len / 2] = x - y;
+        w *= wl;
+      }
+    }
+  }
+  if (inverse) for (auto& v : a) v /= static_cast<double>(n);
+}
+
+// First n terms of the causal convolution g * u.
+std::vector<double> convolve_causal(const std::vector<double>& g, const std::vector<double>& u) {
+  const std::size_t n = u.size();
+  std::vector<double> out(n, 0.0);
+  if (n <= kDirectMax) {
+    for (std::size_t t = 0; t < n; ++t)
+      for (std::size_t s = 0; s <= t; ++s) out[t] += g[t - s] * u[s];
+    return out;
+  }
+  std::size_t m = 1;
+  while (m < 2 * n) m <<= 1;
+  // Pack g and u as real/imag parts of one signal: one forward FFT for both.
+  std::vector<std::complex<double>> z(m);
+  for (std::size_t i = 0; i < n; ++i) z[i] = {g[i], u[i]};
+  fft(z, false);
+  std::vector<std::complex<double>> p(m);
+  for (std::size_t k = 0; k < m; ++k) {
+    const auto zk = z[k], zc = std::conj(z[(m - k) % m]);
+    const auto G = 0.5 * (zk + zc);
+    const auto U = std::complex<double>(0.0, -0.5) * (zk - zc);
+    p[k] = G * U;
+  }
+  fft(p, true);
+  for (std::size_t t = 0; t < n; ++t) out[t] = p[t].real();
+  return out;
+}
+
+} // namespace
+
+std::vector<double> propagate(const PropagatorModel& m, const std::vector<double>& u, double dt_s) {
+  if (!(dt_s > 0.0)) throw std::invalid_argument("propagate: dt_s must be > 0");
+  const PropagatorKernel& K = m.kernel;
+  const std::size_t n = u.size();
+  if (K.kind == KernelKind::Exponential) {
+    if (!(K.tau_s > 0.0)) throw std::invalid_argument("propagate: tau_s must be > 0");
+    const double decay = std::exp(-dt_s / K.tau_s);
+    std::vector<double> I(n);
+    double acc = 0.0;
+    for (std::size_t t = 0; t < n; ++t) {
+      acc = decay * acc + u[t];
+      I[t] = m.kappa * acc;
+    }
+    return I;
+  }
+  if (!(K.l0_s > 0.0) || !(K.beta >= 0.0)) throw std::invalid_argument("propagate: need l0_s > 0, beta >= 0");
+  std::vector<double> g(n);
+  for (std::size_t l = 0; l < n; ++l) g[l] = K.at(static_cast<double>(l) * dt_s);
+  std::vector<double> I = convolve_causal(g, u);
+  for (auto& v : I) v *= m.kappa;
+  return I;
+}
+
+PropagatorSeries build_propagator_series(const Fills& F, const Snaps& M, double dt_s) {
+  if (!(dt_s > 0.0)) throw std::invalid_argument("propagator series: dt_s must be > 0");
+  if (F.empty() || M.empty()) throw std::invalid_argument("propagator series: need fills and snaps");
+
+  PropagatorSeries S;
+  S.dt_s = dt_s;
+  S.t0 = std::floor(F.front().time / dt_s) * dt_s;
+  const double span = F.back().time - S.t0;
+  const auto n = static_cast<std::size_t>(std::floor(span / dt_s)) + 1;
+  S.u.assign(n, 0.0);
+  S.dmid_bps.assign(n, 0.0);
+
+  AsOfCursor cur(M);
+  for (const auto& f : F) {
+    const double s = (f.side == Side::BUY) ? +1.0 : -1.0;
+    const auto t = std::min(n - 1, static_cast<std::size_t>((f.time - S.t0) / dt_s));
+    S.u[t] += s * pov(f.qty, cur.at(f.time).volume);
+  }
+  AsOfCursor mid(M);
+  double prev = mid.at(S.t0).mid;
+  for (std::size_t t = 0; t < n; ++t) {
+    const double m = mid.at(S.t0 + static_cast<double>(t + 1) * dt_s).mid;
+    S.dmid_bps[t] = (m - prev) / prev * 1e4;
+    prev = m;
+  }
+  return S;
+}
+
+std::vector<PropagatorKernel> default_kernel_grid(double dt_s, bool exponential, bool power_law) {
+  std::vector<PropagatorKernel> g;
+  if (exponential)
+    for (double tau : {1.0, 2.0, 5.0, 10.0, 30.0, 60.0, 120.0, 300.0, 600.0, 1800.0}) {
+      PropagatorKernel k;
+      k.kind = KernelKind::Exponential;
+      k.tau_s = std::max(tau, dt_s);
+      g.push_back(k);
+    }
+  if (power_law)
+    for (double beta : {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.8, 1.0, 1.5}) {
+      PropagatorKernel k;
+      k.kind = KernelKind::PowerLaw;
+      k.beta = beta;
+      k.l0_s = dt_s;
+      g.push_back(k);
+    }
+  return g;
+}
+
+PropagatorFit calibrate_propagator(const PropagatorSeries& S,
+                                   const std::vector<PropagatorKernel>& grid,
+                                   unsigned threads) {
+  const std::size_t n = S.u.size();
+  if (n < 3 || S.dmid_bps.size() != n) throw std::invalid_argument("propagator calibration: series too short");
+  if (grid.empty()) throw std::invalid_argument("propagator calibration: empty kernel grid");
+
+  // The fit has no intercept, so R^2 is uncentered: 1 - SSE / sum(y^2). It
+  // lies in [0, 1], and with a shared denominator ranking by it is ranking by SSE.
+  double sst = 0.0;
+  for (double y : S.dmid_bps) sst += y * y;
+
+  PropagatorFit out;
+  out.n = n;
+  out.grid.resize(grid.size());
+  parallel_for(grid.size(), threads, [&](std::size_t b, std::size_t e) {
+    for (std::size_t g = b; g < e; ++g) {
+      PropagatorGridPoint& p = out.grid[g];
+      p.kernel = grid[g];
+      const std::vector<double> I = propagate({grid[g], 1.0}, S.u, S.dt_s);
+      // The mid move over slice t is the change in transient impact.
+      double sxx = 0.0, sxy = 0.0, prev = 0.0;
+      for (std::size_t t = 0; t < n; ++t) {
+        const double x = I[t] - prev;
+        prev = I[t];
+        sxx += x * x; sxy += x * S.dmid_bps[t];
+      }
+      p.kappa = sxx > 0.0 ? sxy / sxx : 0.0;
+      const double sse = std::max(0.0, sst - p.kappa * sxy);
+      p.r2 = sst > 0.0 ? 1.0 - sse / sst : 0.0;
+    }
+  });
+
+  std::size_t best = 0;
+  for (std::size_t g = 1; g < out.grid.size(); ++g)
+    if (out.grid[g].r2 > out.grid[best].r2) best = g;
+  out.model = {out.grid[best].kernel, out.grid[best].kappa};
+  out.r2 = out.grid[best].r2;
+  return out;
+}
+
+PropagatorCost propagator_cost(const PropagatorModel& m,
+                               const OrderSpec& spec,
+                               const Snaps& forecast,
+                               const Schedule& schedule) {
+  const std::size_t n = schedule.x.size();
+  if (n == 0 || forecast.size() != n) throw std::invalid_argument("propagator cost: schedule/forecast size mismatch");
+  const double dt = slice_seconds(spec, forecast);
+
+  // Own-order participation is unsigned: the order's side is the adverse direction.
+  std::vector<double> u(n);
+  for (std::size_t j = 0; j < n; ++j) u[j] = pov(schedule.x[j], forecast[j].volume);
+
+  PropagatorCost c;
+  c.impact_bps = propagate(m, u, dt);
+  double q = 0.0, w = 0.0;
+  for (std::size_t j = 0; j < n; ++j) { q += schedule.x[j]; w += schedule.x[j] * c.impact_bps[j]; }
+  c.cost_bps = q > 0.0 ? w / q : 0.0;
+  return c;
+}
+
+void write_propagator_json(const std::string& path, const PropagatorModel& m) {
+  json j{{"kernel", to_string(m.kernel.kind)}, {"kappa", m.kappa}};
+  if (m.kernel.kind == KernelKind::Exponential) j["tau_s"] = m.kernel.tau_s;
+  else { j["beta"] = m.kernel.beta; j["l0_s"] = m.kernel.l0_s; }
+  std::ofstream out(path);
+  if (!out) throw std::runtime_error("cannot write " + path);
+  out << j.dump(2);
+}
+
+PropagatorModel load_propagator_json(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("cannot open " + path);
+  json j;
+  in >> j;
+  PropagatorModel m;
+  const std::string kind = j.value("kernel", "exp");
+  if (kind == "power") m.kernel.kind = KernelKind::PowerLaw;
+  else if (kind == "exp") m.kernel.kind = KernelKind::Exponential;
+  else throw std::runtime_error("propagator json: unknown kernel '" + kind + "'");
+  m.kernel.tau_s = j.value("tau_s", m.kernel.tau_s);
+  m.kernel.beta  = j.value("beta", m.kernel.beta);
+  m.kernel.l0_s  = j.value("l0_s", m.kernel.l0_s);
+  m.kappa = j.at("kappa").get<double>();
+  return m;
+}
+
+} // namespace tca
@@ -0,0 +1,20 @@
+#include "../include/tca/Regressors.hpp"
+
+namespace tca {
+
+template <class R>
+static ImpactFit fit_with(const Fills& fills, const Snaps& snaps) {
+  return solve_typed<R>(accumulate_temp_impact_typed<R>(fills, snaps));
+}
+
+ImpactFit fit_temporary_impact_typed(const Fills& fills,
+                                     const Snaps& snaps,
+                                     bool include_spread_control,
+                                     bool include_sigma_control) {
+  if (include_spread_control && include_sigma_control) return fit_with<RegFull>(fills, snaps);
+  if (include_spread_control)                          return fit_with<RegSpread>(fills, snaps);
+  if (include_sigma_control)                           return fit_with<RegSigma>(fills, snaps);
+  return fit_with<RegPOVOnly>(fills, snaps);
+}
+
+} // namespace tca
@@ -1,4 +1,6 @@
 #include "tca/Report.hpp"
+#include "tca/ImpactJson.hpp"
+#include <cmath>
 #include <fstream>
 #include <stdexcept>
 #include <nlohmann/json.hpp>
@@ -17,10 +19,29 @@ static json to_json(const ISBreakdown& b) {
   };
 }
 
-static json to_json(const ImpactParams& p) {
+// NaN benchmarks (not formable from the inputs) serialize as null.
+static json bench_value(double v) { return std::isfinite(v) ? json(v) : json(nullptr); }
+
+static json to_json(const BenchmarkIS& b) {
   return json{
-    {"eta_bp_per_10pov", p.eta_bp_per_10pov},
-    {"gamma_bp_per_10pov", p.gamma_bp_per_10pov}
+    {"avg_px", b.avg_px},
+    {"prices", {
+      {"arrival", bench_value(b.px.arrival)},
+      {"interval_vwap", bench_value(b.px.interval_vwap)},
+      {"interval_twap", bench_value(b.px.interval_twap)},
+      {"open", bench_value(b.px.open)},
+      {"prev_close", bench_value(b.px.prev_close)},
+      {"end_mid", bench_value(b.px.end_mid)}
+    }},
+    {"slippage_bps", {
+      {"arrival", bench_value(b.vs_arrival_bps)},
+      {"interval_vwap", bench_value(b.vs_vwap_bps)},
+      {"interval_twap", bench_value(b.vs_twap_bps)},
+      {"open", bench_value(b.vs_open_bps)},
+      {"prev_close", bench_value(b.vs_prev_close_bps)},
+      {"end_mid", bench_value(b.vs_end_bps)}
+    }},
+    {"arrival_breakdown", to_json(b.arrival)}
   };
 }
 
@@ -30,19 +51,50 @@ static json to_json(const Schedule& s) {
   return a;
 }
 
+static json to_json(const ISAttribution& A) {
+  json cells = json::array();
+  for (const auto& c : A.cells) {
+    json row{
+      {"venue", A.venues[static_cast<size_t>(c.venue)]},
+      {"time_bucket", c.time_bucket},
+      {"size_bucket", c.size_bucket},
+      {"side", c.side},
+      {"fills", c.fills},
+      {"qty", c.qty},
+      {"notional", c.notional}
+    };
+    row.update(to_json(c.contrib));
+    cells.push_back(row);
+  }
+  return json{
+    {"time_origin", A.time_origin},
+    {"time_bucket_s", A.spec.time_bucket_s},
+    {"size_edges", A.spec.size_edges},
+    {"cells", cells}
+  };
+}
+
 void write_report_json(const std::string& path, const TCAReport& R, bool pretty) {
   json j{
     {"symbol", R.symbol},
     {"arrival_mid", R.arrival_mid},
     {"is", to_json(R.is)},
-    {"impact", to_json(R.impact)},
+    {"benchmarks", to_json(R.benchmarks)},
+    {"impact", json(R.impact)},
     {"schedule", to_json(R.schedule)}
   };
+  if (!R.attribution.cells.empty()) j["attribution"] = to_json(R.attribution);
   std::ofstream out(path);
   if (!out) throw std::runtime_error("cannot write " + path);
   out << (pretty ? j.dump(2) : j.dump());
 }
 
+void write_impact_json(const std::string& path, const ImpactParams& p) {
+  std::ofstream out(path);
+  if (!out) throw std::runtime_error("cannot write " + path);
+  out << json(p).dump(2) << "\n";
+}
+
 void write_schedule_csv(const std::string& path, const Schedule& s) {
   std::ofstream out(path);
   if (!out) throw std::runtime_error("cannot write " + path);
@@ -61,4 +113,18 @@ void write_is_csv(const std::string& path, const ISBreakdown& b) {
   out << "residual_bps,"<< b.residual_bps << "\n";
 }
 
+void write_attribution_csv(const std::string& path, const ISAttribution& A) {
+  std::ofstream out(path);
+  if (!out) throw std::runtime_error("cannot write " + path);
+  out << "venue,time_bucket,bucket_start,size_bucket,side,fills,qty,notional,"
+         "is_bps,spread_bps,fees_bps,timing_bps,residual_bps\n";
+  for (const auto& c : A.cells) {
+    const double start = A.time_origin + c.time_bucket * A.spec.time_bucket_s;
+    out << A.venues[static_cast<size_t>(c.venue)] << "," << c.time_bucket << "," << start << ","
+        << c.size_bucket << "," << c.side << "," << c.fills << "," << c.qty << "," << c.notional << ","
+        << c.contrib.is_bps << "," << c.contrib.spread_bps << "," << c.contrib.fees_bps << ","
+        << c.contrib.timing_bps << "," << c.contrib.residual_bps << "\n";
+  }
+}
+
 } // namespace tca
@@ -0,0 +1,313 @@
+#include "../include/tca/ScheduleQP.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace tca {
+
+namespace {
+
+constexpr double kAlpha = 1.6;     // ADMM over-relaxation
+constexpr double kPinDual = 1e-9;  // scaled dual below which a bound is not active
+constexpr int kPolishRounds = 8;   // active-set repairs per polish attempt
+constexpr int kPolishEvery = 10;   // ADMM iterations between polish attempts
+
+// LDL' of M = D'(2A + rho I)D + 2B, tridiagonal in the n-1 holdings.
+// Row j of D maps holdings to trade j: f_j = h_{j-1} - h_j (h_{-1} = 1, h_{n-1} = 0).
+void factor(ScheduleQPWorkspace& w, std::size_t n) {
+  const std::size_t m = n - 1;
+  for (std::size_t k = 0; k < m; ++k) {
+    const double d = 2.0 * w.a[k] + w.rho + 2.0 * w.a[k + 1] + w.rho + 2.0 * w.b[k];
+    if (k == 0) { w.l[0] = d; continue; }
+    const double off = -(2.0 * w.a[k] + w.rho);
+    w.m[k - 1] = off / w.l[k - 1];
+    w.l[k] = d - w.m[k - 1] * off;
+  }
+}
+
+void solve(ScheduleQPWorkspace& w, std::size_t m) {
+  double* r = w.rhs.data();
+  for (std::size_t k = 1; k < m; ++k) r[k] -= w.m[k - 1] * r[k - 1];
+  w.h[m - 1] = r[m - 1] / w.l[m - 1];
+  for (std::size_t k = m - 1; k-- > 0;) w.h[k] = r[k] / w.l[k] - w.m[k] * w.h[k + 1];
+}
+
+inline double trade(const ScheduleQPWorkspace& w, std::size_t j, std::size_t n) {
+  const double prev = (j == 0) ? 1.0 : w.h[j - 1];
+  const double next = (j == n - 1) ? 0.0 : w.h[j];
+  return prev - next;
+}
+
+// Active bound of slice j: -1 floor, 1 cap, 2 fixed (floor == cap), 0 free.
+// A clamped slice whose dual is still ~0 is left free (degenerate bound).
+inline int bound_of(const ScheduleQPWorkspace& w, std::size_t j) {
+  if (w.lo[j] >= w.hi[j]) return 2;
+  if (w.z[j] <= w.lo[j] && w.u[j] < -kPinDual) return -1;
+  if (w.z[j] >= w.hi[j] && w.u[j] > kPinDual) return 1;
+  return 0;
+}
+
+// Equality-constrained solve with every slice in w.at pinned to its bound;
+// trades into w.tmp. Pinned slices merge their cumulative fills into one
+// group (offset from the group's base), so the reduced system over the
+// free group bases is again tridiagonal. Group 0 is anchored at 0 (before
+// the first slice), the last group at 1 (completion).
+bool solve_active(ScheduleQPWorkspace& w, std::size_t n) {
+  std::size_t G = 0;
+  double o = 0.0;
+  for (std::size_t j = 0; j < n; ++j) {
+    if (w.at[j] != 0) o += w.at[j] == 1 ? w.hi[j] : w.lo[j];
+    else { ++G; o = 0.0; }
+    w.grp[j] = G; w.off[j] = o;
+  }
+  const double last = 1.0 - w.off[n - 1];   // base of group G
+  if (G == 0) {
+    if (std::abs(last) > 1e-12) return false;
+    for (std::size_t j = 0; j < n; ++j) w.tmp[j] = w.at[j] == 1 ? w.hi[j] : w.lo[j];
+    return true;
+  }
+
+  // Reduced system over bases 1..G-1 (index q = group - 1).
+  const std::size_t nb = G - 1;
+  w.pd.assign(nb, 0.0); w.po.assign(nb, 0.0); w.pr.assign(nb, 0.0);
+  for (std::size_t j = 0; j < n; ++j) {
+    const std::size_t g = w.grp[j];
+    if (w.at[j] == 0) {
+      // Free trade j: f = B_g - B_{g-1} - off_{j-1}.
+      const double oj = j > 0 ? w.off[j - 1] : 0.0;
+      const double h2 = 2.0 * w.a[j], lin = h2 * oj - w.c[j];
+      const bool kn = g == G, kp = g == 1;
+      if (!kn) { w.pd[g - 1] += h2; w.pr[g - 1] += lin; }
+      if (!kp) { w.pd[g - 2] += h2; w.pr[g - 2] -= lin; }
+      if (!kn && !kp) w.po[g - 2] -= h2;
+      else if (!kp) w.pr[g - 2] += h2 * last;
+    }
+    if (j + 1 < n && g != 0 && g != G) {
+      w.pd[g - 1] += 2.0 * w.b[j];
+      w.pr[g - 1] += 2.0 * w.b[j] * (1.0 - w.off[j]);
+    }
+  }
+  for (std::size_t q = 1; q < nb; ++q) {
+    if (!(w.pd[q - 1] > 0.0)) return false;
+    const double r = w.po[q - 1] / w.pd[q - 1];
+    w.pd[q] -= r * w.po[q - 1];
+    w.pr[q] -= r * w.pr[q - 1];
+  }
+  if (nb > 0) {
+    if (!(w.pd[nb - 1] > 0.0)) return false;
+    w.pr[nb - 1] /= w.pd[nb - 1];
+    for (std::size_t q = nb - 1; q-- > 0;) w.pr[q] = (w.pr[q] - w.po[q] * w.pr[q + 1]) / w.pd[q];
+  }
+
+  double prev = 0.0;
+  for (std::size_t j = 0; j < n; ++j) {
+    const std::size_t g = w.grp[j];
+    const double B = g == 0 ? 0.0 : g == G ? last : w.pr[g - 1];
+    const double cum = B + w.off[j];
+    w.tmp[j] = cum - prev;
+    prev = cum;
+  }
+  return true;
+}
+
+// Polish: take the bounds z sits on as the active set, solve exactly, and
+// repair the set a few times (free a bound with a wrong-signed multiplier,
+// pin a free slice that left its box). Accepted only when KKT holds, so a
+// polished result is optimal to rounding.
+bool polish(ScheduleQPWorkspace& w, std::size_t n) {
+  w.at.resize(n); w.grp.resize(n); w.off.resize(n);
+  for (std::size_t j = 0; j < n; ++j) w.at[j] = bound_of(w, j);
+  for (int round = 0; round < kPolishRounds; ++round) {
+    if (!solve_active(w, n)) return false;
+
+    // df_j = 2 a_j f_j + c_j - 2 sum_{i>=j} b_i h_i is -mu on free slices,
+    // >= -mu at a floor and <= -mu at a cap.
+    double tail = 0.0, cum = 1.0, gmax = 0.0, gfree = 0.0;
+    double floor_min = HUGE_VAL, cap_max = -HUGE_VAL;
+    std::size_t nfree = 0;
+    for (std::size_t j = n; j-- > 0;) {
+      if (j + 1 < n) tail += w.b[j] * (1.0 - cum);
+      const double g = 2.0 * w.a[j] * w.tmp[j] + w.c[j] - 2.0 * tail;
+      w.scratch[j] = g;
+      gmax = std::max(gmax, std::abs(g));
+      if (w.at[j] == 0) { gfree += g; ++nfree; }
+      else if (w.at[j] == -1) floor_min = std::min(floor_min, g);
+      else if (w.at[j] == 1) cap_max = std::max(cap_max, g);
+      cum -= w.tmp[j];
+    }
+    double m = 0.0;
+    if (nfree > 0) m = gfree / static_cast<double>(nfree);
+    else if (std::isfinite(floor_min) && std::isfinite(cap_max)) m = 0.5 * (floor_min + cap_max);
+    else if (std::isfinite(floor_min)) m = floor_min;
+    else if (std::isfinite(cap_max)) m = cap_max;
+    const double tol = 1e-9 * (1.0 + gmax);
+
+    bool changed = false;
+    for (std::size_t j = 0; j < n; ++j) {
+      const double btol = 1e-12 * (1.0 + w.hi[j]);
+      int at = w.at[j];
+      if (at == 0 && w.tmp[j] < w.lo[j] - btol) at = -1;
+      else if (at == 0 && w.tmp[j] > w.hi[j] + btol) at = 1;
+      else if (at == -1 && w.scratch[j] < m - tol) at = 0;
+      else if (at == 1 && w.scratch[j] > m + tol) at = 0;
+      if (at != w.at[j]) { w.at[j] = at; changed = true; }
+    }
+    if (!changed) {
+      std::copy(w.tmp.begin(), w.tmp.end(), w.z.begin());
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+ScheduleQPResult optimize_schedule_qp(const OrderSpec& spec,
+                                      const Snaps& forecast,
+                                      const ImpactParams& impact,
+                                      const ScheduleQPOptions& opt,
+                                      ScheduleQPWorkspace& w) {
+  if (spec.qty <= 0.0) throw std::invalid_argument("OrderSpec.qty must be > 0");
+  if (spec.slices <= 0 || static_cast<int>(forecast.size()) != spec.slices)
+    throw std::invalid_argument("forecast.size() must equal OrderSpec.slices");
+  if (spec.min_pov < 0.0 || spec.min_pov > std::max(0.0, spec.max_pov))
+    throw std::invalid_argument("OrderSpec.min_pov must be in [0, max_pov]");
+
+  const std::size_t n = forecast.size();
+  const double X = std::abs(spec.qty);
+  const double sgn = (spec.side == Side::BUY) ? 1.0 : -1.0;
+  const double tau = slice_seconds(spec, forecast);
+  const double eta10 = std::max(0.0, impact.eta_bp_per_10pov);
+  const double gamma10 = std::max(0.0, impact.gamma_bp_per_10pov);
+  const double lambda = std::max(0.0, spec.risk_lambda);
+
+  double vbar = 0.0;
+  std::size_t nv = 0;
+  for (const auto& s : forecast) if (s.volume > 0.0) { vbar += s.volume; ++nv; }
+  vbar = nv > 0 ? vbar / static_cast<double>(nv) : 0.0;
+  const double gamma_frac = vbar > 0.0 ? 10.0 * gamma10 * X / vbar : 0.0;
+
+  if (w.h.size() + 1 != n) w.warm = false;
+  w.a.resize(n); w.b.resize(n); w.c.resize(n); w.lo.resize(n); w.hi.resize(n);
+  w.z.resize(n); w.u.resize(n); w.tmp.resize(n); w.scratch.resize(2 * n);
+  w.h.resize(n - 1); w.l.resize(n - 1); w.m.resize(n > 1 ? n - 2 : 0); w.rhs.resize(n - 1);
+
+  // Per-slice weights on order fractions (see evaluate_schedule); the
+  // permanent term -gamma/2 * sum f^2 is folded into a, kept positive.
+  double lo_sum = 0.0, hi_sum = 0.0, a_mean = 0.0;
+  for (std::size_t j = 0; j < n; ++j) {
+    const Snap& s = forecast[j];
+    const double V = std::max(0.0, s.volume);
+    const double temp = V > 0.0 ? 10.0 * eta10 * X / V : 0.0;
+    w.a[j] = std::max(temp - 0.5 * gamma_frac, 1e-9 * (1.0 + temp));
+    w.c[j] = 0.5 * std::max(0.0, s.spread_bps);
+    const double sg = sigma_bps_per_sqrt_s(s.sigma);
+    w.b[j] = lambda * sg * sg * tau;
+    const double cap = cap_for_slice(spec.max_pov, V) / X;
+    w.hi[j] = cap;
+    w.lo[j] = std::min(cap, cap_for_slice(spec.min_pov, V) / X);
+    lo_sum += w.lo[j]; hi_sum += w.hi[j]; a_mean += 2.0 * w.a[j];
+  }
+  a_mean /= static_cast<double>(n);
+
+  ScheduleQPResult R;
+  // short_caps: infeasible because of the caps (scaled-down floors fill the order).
+  auto finish = [&](bool feasible, bool short_caps = true) {
+    R.schedule.x.resize(n);
+    double filled = 0.0;
+    for (std::size_t j = 0; j < n; ++j) { R.schedule.x[j] = sgn * X * w.z[j]; filled += X * w.z[j]; }
+    R.schedule.feasible = feasible;
+    R.schedule.shortfall = (feasible || !short_caps) ? 0.0 : std::max(0.0, X - filled);
+    R.cost = evaluate_schedule(spec, forecast, impact, R.schedule);
+    return R;
+  };
+
+  // Infeasible boxes, no ADMM: caps too small -> trade the caps (short);
+  // floors above the order -> floors scaled down to exactly the order.
+  if (hi_sum < 1.0 - 1e-12) { std::copy(w.hi.begin(), w.hi.end(), w.z.begin()); w.warm = false; return finish(false); }
+  if (lo_sum > 1.0 + 1e-12) {
+    for (std::size_t j = 0; j < n; ++j) w.z[j] = w.lo[j] / lo_sum;
+    w.warm = false;
+    return finish(false, false);
+  }
+  if (n == 1) { w.z[0] = 1.0; R.converged = true; return finish(true); }
+
+  const std::size_t m = n - 1;
+  if (!w.warm) {
+    // Cold start: linear holdings, trades clamped into the box.
+    for (std::size_t k = 0; k < m; ++k) w.h[k] = 1.0 - static_cast<double>(k + 1) / static_cast<double>(n);
+    for (std::size_t j = 0; j < n; ++j) { w.z[j] = std::clamp(trade(w, j, n), w.lo[j], w.hi[j]); w.u[j] = 0.0; }
+    w.rho = opt.rho > 0.0 ? opt.rho : std::max(a_mean, 1e-6);
+  } else if (opt.rho > 0.0 && !opt.adaptive_rho) {
+    for (auto& v : w.u) v *= w.rho / opt.rho;
+    w.rho = opt.rho;
+  }
+  const bool warm = w.warm;
+  factor(w, n);
+
+  const double sqn = std::sqrt(static_cast<double>(n));
+  for (int it = 1; it <= opt.max_iter; ++it) {
+    R.iterations = it;
+    // x-update: M h = -D'v with v = 2A e + c + rho (e - z + u), e = unit trade in slice 0.
+    for (std::size_t j = 0; j < n; ++j) {
+      const double e = (j == 0) ? 1.0 : 0.0;
+      w.tmp[j] = 2.0 * w.a[j] * e + w.c[j] + w.rho * (e - w.z[j] + w.u[j]);
+    }
+    for (std::size_t k = 0; k < m; ++k) w.rhs[k] = w.tmp[k] - w.tmp[k + 1];
+    solve(w, m);
+
+    // z-update (box clamp) and scaled dual ascent; residual norms on the way.
+    double rp2 = 0.0, rd2 = 0.0, fx2 = 0.0, z2 = 0.0, u2 = 0.0, dz_prev = 0.0;
+    for (std::size_t j = 0; j < n; ++j) {
+      const double f = trade(w, j, n);
+      const double fr = kAlpha * f + (1.0 - kAlpha) * w.z[j];   // over-relaxation
+      const double zn = std::clamp(fr + w.u[j], w.lo[j], w.hi[j]);
+      const double dz = zn - w.z[j];
+      if (j > 0) { const double s = dz - dz_prev; rd2 += s * s; }   // (D'dz)_k = dz_{k+1} - dz_k
+      dz_prev = dz;
+      w.z[j] = zn;
+      w.u[j] += fr - zn;
+      const double r = f - zn;
+      rp2 += r * r; fx2 += f * f; z2 += zn * zn; u2 += w.u[j] * w.u[j];
+    }
+    R.primal_residual = std::sqrt(rp2);
+    R.dual_residual = w.rho * std::sqrt(rd2);
+    const double eps_pri = sqn * opt.eps_abs + opt.eps_rel * std::sqrt(std::max(fx2, z2));
+    const double eps_dual = sqn * opt.eps_abs + opt.eps_rel * w.rho * 2.0 * std::sqrt(u2);
+    if (R.primal_residual <= eps_pri && R.dual_residual <= eps_dual) { R.converged = true; break; }
+    if (opt.polish && (it % kPolishEvery == 0 || (it == 1 && warm)) && polish(w, n)) {
+      R.converged = R.polished = true;
+      break;
+    }
+
+    if (opt.adaptive_rho && it % 25 == 0) {
+      // Balance the normalized residuals (OSQP rule); refactor only on a big move.
+      const double pn = R.primal_residual / std::max(std::sqrt(std::max(fx2, z2)), 1e-30);
+      const double dn = R.dual_residual / std::max(w.rho * 2.0 * std::sqrt(u2), 1e-30);
+      const double scale = std::clamp(std::sqrt(pn / std::max(dn, 1e-30)), 1e-3, 1e3);
+      if (scale > 5.0 || scale < 0.2) {
+        w.rho *= scale;
+        for (auto& v : w.u) v /= scale;
+        factor(w, n);
+      }
+    }
+  }
+  w.warm = true;
+
+  // Exact feasibility: project z onto {lo <= z <= hi, sum z = 1}.
+  for (std::size_t j = 0; j < n; ++j) { w.tmp[j] = w.z[j] - w.lo[j]; w.hi[j] -= w.lo[j]; }
+  const auto st = project_capped_simplex(std::span<double>(w.tmp), std::span<const double>(w.hi),
+                                         std::max(0.0, 1.0 - lo_sum), std::span<double>(w.scratch));
+  for (std::size_t j = 0; j < n; ++j) { w.z[j] = w.tmp[j] + w.lo[j]; w.hi[j] += w.lo[j]; }
+  return finish(st == ProjectionStatus::Ok);
+}
+
+ScheduleQPResult optimize_schedule_qp(const OrderSpec& spec,
+                                      const Snaps& forecast,
+                                      const ImpactParams& impact,
+                                      const ScheduleQPOptions& opt) {
+  ScheduleQPWorkspace ws;
+  return optimize_schedule_qp(spec, forecast, impact, opt, ws);
+}
+
+} // namespace tca
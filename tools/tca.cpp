@@ -2,30 +2,125 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cmath>
+#include <limits>
 #include <stdexcept>
 #include <nlohmann/json.hpp>
 
 #include "../include/tca/Types.hpp"
 #include "tca/IO.hpp"
+#include "tca/utils.hpp"
 #include "tca/Market.hpp"
 #include "tca/IS.hpp"
+#include "tca/ISKernel.hpp"
+#include "tca/Rng.hpp"
+#include "tca/Reduce.hpp"
+#include "tca/Attribution.hpp"
 #include "tca/Impact.hpp"
+#include "tca/ImpactOnline.hpp"
+#include "tca/ImpactRolling.hpp"
+#include "tca/ImpactPanel.hpp"
+#include "tca/ImpactPowerLaw.hpp"
+#include "tca/ImpactCV.hpp"
+#include "tca/ImpactRobust.hpp"
+#include "tca/ImpactStore.hpp"
+#include "tca/ImpactVenue.hpp"
+#include "tca/Regressors.hpp"
 #include "tca/Optimize.hpp"
+#include "tca/ScheduleQP.hpp"
+#include "tca/OptimizeBatch.hpp"
+#include "tca/Propagator.hpp"
 #include "tca/Report.hpp"
+#include "tca/Bootstrap.hpp"
 
 using namespace tca;
 using nlohmann::json;
 
 static void die(const std::string& msg){ std::cerr << "error: " << msg << "\n"; std::exit(2); }
+// Report controls a fit dropped as aliased (offset 1 for slope-only fits).
+static void note_aliased(const std::vector<int>& aliased, bool sp, bool sg, int offset=0) {
+  if (aliased.empty()) return;
+  std::cerr<<"note: dropped aliased control(s):";
+  for (int c : aliased) std::cerr<<" "<<temp_impact_column_name(c+offset, sp, sg);
+  std::cerr<<"\n";
+}
+static std::vector<double> parse_doubles(const std::string& s) {
+  std::vector<double> v;
+  for (const auto& c : split_csv(s)) if (!trim(c).empty()) v.push_back(std::stod(c));
+  return v;
+}
+// --impact file, or a per-symbol lookup in an --impact-table from fit-panel
+// or in an --store written by fit-impact --store.
+// Stored fit for sym: fit-impact's default spec first; any other record
+// must still be a temp-OLS fit, and its spec is named on stderr.
+static ImpactParams stored_impact(const ImpactStoreView& store, const std::string& storep,
+                                  const std::string& sym) {
+  const ImpactRecord* r = store.latest(sym, spec_hash(temp_impact_spec(true, true)));
+  if (!r) {
+    r = store.latest(sym);
+    if (!r) throw std::runtime_error("no stored impact for " + sym + " in " + storep);
+    const std::string spec = temp_impact_spec_name(r->spec_hash);
+    if (spec.empty()) throw std::runtime_error("stored impact for " + sym + " has an unknown model spec");
+    std::cerr<<"note: using stored "<<spec<<" fit for "<<sym<<"\n";
+  }
+  return r->params();
+}
+// Schedules and costs use linear temporary impact; a power-law beta is
+// carried in impact.json but not applied.
+static bool nonlinear_beta(const ImpactParams& p) { return std::abs(p.beta - 1.0) > 1e-12; }
+static void warn_beta(const ImpactParams& p) {
+  if (nonlinear_beta(p))
+    std::cerr<<"warning: impact beta="<<p.beta<<" is ignored; the optimizer and cost model are linear in POV\n";
+}
+static ImpactParams load_impact(const std::string& impactp, const std::string& tablep,
+                                const std::string& storep, const std::string& sym) {
+  if ((!storep.empty() || !tablep.empty()) && sym.empty())
+    throw std::runtime_error("--impact-table and --store need --symbol");
+  ImpactParams p;
+  if (!storep.empty()) p = stored_impact(ImpactStoreView(storep), storep, sym);
+  else if (!tablep.empty()) {
+    const ImpactTable T = load_impact_table_json(tablep);
+    const ImpactParams* q = T.find(sym);
+    if (!q) std::cerr<<"warning: "<<sym<<" is not in "<<tablep<<"; using its pooled params\n";
+    p = q ? *q : T.pooled;
+  }
+  else p = load_impact_json(impactp);
+  warn_beta(p);
+  return p;
+}
 static void usage() {
   std::cerr <<
   "tca <subcommand> [options]\n\n"
   "Subcommands:\n"
-  "  is --fills F --mkt M --arrival P0\n"
-  "  fit-impact --fills F --mkt M [--no-spread] [--no-sigma]\n"
-  "  optimize --order order.json --mkt M --impact impact.json --out schedule.csv\n"
-  "  report --symbol SYM --fills F --mkt M --arrival P0 --impact impact.json "
-  "          --order order.json --out report.json [--sched schedule.csv] [--is is.csv]\n";
+  "  is --fills F --mkt M --arrival P0 [--prev-close PC]\n"
+  "  is-check [--fills F --mkt M --arrival P0 | --n N] [--tol BPS] [--threads T] [--det-threads T]\n"
+  "        (SIMD kernels vs the scalar IS loop, and IS / Gram / attribution sums bitwise\n"
+  "         at 1 vs --det-threads threads; synthetic fills unless files are given)\n"
+  "  is-ci --orders orders.jsonl [--unit order|fill] [--reps N] [--seed S] [--threads T]\n"
+  "        [--alpha A] [--equal-weight]   (jsonl lines: {\"fills\",\"mkt\",\"arrival\"})\n"
+  "  fit-impact --fills F --mkt M [--no-spread] [--no-sigma] [--out impact.json], plus at most one mode:\n"
+  "             [--stream [--threads T]] [--rls LAMBDA]\n"
+  "             [--rolling DAYS [--step N] [--day-s S]] [--perm-horizons h1,h2,... [--order-gap S] [--gamma-horizon H]]\n"
+  "             [--power-law] [--typed] [--bucketed] [--venue-fe]\n"
+  "             [--robust [--robust-loss huber|tukey] [--tuning C] [--threads T]]\n"
+  "             [--bootstrap N [--block time|order] [--block-s S] [--order-gap S] [--seed S] [--alpha A]]\n"
+  "             [--cv [--folds K] [--gap-blocks G] [--block-s S] [--lambdas l1,l2,...]]\n"
+  "             [--store impact.store --symbol SYM [--threads T]]\n"
+  "  fit-panel --universe universe.jsonl --out table.json [--threads T] [--no-spread] [--no-sigma]\n"
+  "  fit-propagator --fills F --mkt M [--dt S] [--kernel exp|power|both] [--threads T]\n"
+  "                 [--out propagator.json]\n"
+  "  optimize --order order.json --mkt M (--impact impact.json | (--impact-table T | --store S) --symbol SYM)\n"
+  "           --out schedule.csv [--propagator propagator.json] [--qp [--qp-tol EPS]]\n"
+  "  optimize-batch --orders orders.jsonl --mkt-dir DIR (--impact impact.json | --impact-table T | --store S)\n"
+  "                 --out schedules.csv [--qp [--qp-tol EPS]] [--threads T] [--grain N]\n"
+  "                 (jsonl lines: order.json keys plus \"symbol\"; forecast DIR/<symbol>.csv)\n"
+  "  report --symbol SYM --fills F --mkt M --arrival P0 (--impact impact.json | --impact-table T | --store S)\n"
+  "          --order order.json --out report.json [--sched schedule.csv] [--is is.csv] [--prev-close PC]\n"
+  "          [--attrib attrib.csv] [--bucket-s S] [--size-edges q1,q2,...] [--by-side] [--no-venue]\n"
+  "          [--threads T]\n";
 }
 
 int main(int argc, char** argv) {
@@ -34,80 +129,593 @@ int main(int argc, char** argv) {
 
   try {
     if (cmd == "is") {
-      std::string fills, mkt; double p0 = 0.0;
+      std::string fills, mkt; double p0 = 0.0, pc = 0.0;
       for (int i=2;i<argc;++i){
         std::string a=argv[i];
         if (a=="--fills"&&i+1<argc) fills=argv[++i];
         else if (a=="--mkt"&&i+1<argc) mkt=argv[++i];
         else if (a=="--arrival"&&i+1<argc) p0=std::stod(argv[++i]);
+        else if (a=="--prev-close"&&i+1<argc) pc=std::stod(argv[++i]);
       }
       if (fills.empty()||mkt.empty()||p0<=0.0) die("is: need --fills --mkt --arrival");
       auto F = load_fills_csv(fills);
       auto M = load_snaps_csv(mkt);
-      auto b = compute_is(F,M,p0);
+      // One walk: the arrival breakdown comes with the benchmarks.
+      auto bm = compute_is_benchmarks(F,M,p0,pc);
+      const auto& b = bm.arrival;
       std::cout.setf(std::ios::fixed); std::cout.precision(3);
       std::cout<<"IS (bps): "<<b.is_bps<<"\n  Spread: "<<b.spread_bps
                <<"\n  Fees: "<<b.fees_bps<<"\n  Timing: "<<b.timing_bps
                <<"\n  Residual: "<<b.residual_bps<<"\n";
+      std::cout<<"Slippage vs benchmarks (bps):"
+               <<"\n  Arrival:       "<<bm.vs_arrival_bps
+               <<"\n  Interval VWAP: "<<bm.vs_vwap_bps
+               <<"\n  Interval TWAP: "<<bm.vs_twap_bps
+               <<"\n  Open:          "<<bm.vs_open_bps
+               <<"\n  Prev close:    ";
+      if (std::isnan(bm.vs_prev_close_bps)) std::cout<<"n/a (no --prev-close)";
+      else std::cout<<bm.vs_prev_close_bps;
+      std::cout<<"\n  End mid:       "<<bm.vs_end_bps<<"\n";
+      return 0;
+    }
+
+    if (cmd == "is-check") {
+      std::string fills, mkt; double p0 = 0.0, tol = 1e-8;
+      std::size_t n = 10007; unsigned threads = 4, det_threads = 64;
+      for (int i=2;i<argc;++i){
+        std::string a=argv[i];
+        if (a=="--fills"&&i+1<argc) fills=argv[++i];
+        else if (a=="--mkt"&&i+1<argc) mkt=argv[++i];
+        else if (a=="--arrival"&&i+1<argc) p0=std::stod(argv[++i]);
+        else if (a=="--n"&&i+1<argc) n=std::stoul(argv[++i]);
+        else if (a=="--tol"&&i+1<argc) tol=std::stod(argv[++i]);
+        else if (a=="--threads"&&i+1<argc) threads=static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (a=="--det-threads"&&i+1<argc) det_threads=static_cast<unsigned>(std::stoul(argv[++i]));
+      }
+      Fills F; Snaps M;
+      if (!fills.empty()||!mkt.empty()) {
+        if (fills.empty()||mkt.empty()) die("is-check: need both --fills and --mkt");
+        F = load_fills_csv(fills);
+        M = load_snaps_csv(mkt);
+        if (p0<=0.0) p0 = infer_arrival_mid(F,M);
+      } else {
+        // Deterministic synthetic day: n fills (odd count leaves SIMD tails),
+        // mixed sides and venues, prices on both sides of the mid.
+        auto u = [](std::uint64_t s, std::uint64_t c){ return static_cast<double>(counter_draw(7, s, c) >> 11) * 0x1.0p-53; };
+        for (std::size_t k=0;k<1000;++k)
+          M.push_back({static_cast<double>(k), 50.0 + 2.0*u(0,k), 1.0 + 3.0*u(1,k), 1e4, 0.25});
+        for (std::size_t k=0;k<n;++k) {
+          const double t = 1000.0 * static_cast<double>(k) / static_cast<double>(n);
+          const double mid = M[static_cast<std::size_t>(t)].mid;
+          F.push_back({t, u(2,k) < 0.8 ? Side::BUY : Side::SELL, 1.0 + std::floor(500.0*u(3,k)),
+                       mid * (1.0 + 4e-4*(u(4,k)-0.5)), u(6,k) < 0.5 ? "X" : u(6,k) < 0.8 ? "Y" : "Z", 0.5*u(5,k)});
+        }
+        p0 = M.front().mid;
+      }
+      if (F.empty()||M.empty()) die("is-check: no fills or snaps");
+      const auto c = check_is_kernels(F, M, p0, threads);
+      bool ok = true;
+      auto line = [&](const char* name, double d) {
+        const bool pass = std::isnan(d) || d <= tol;
+        ok = ok && pass;
+        std::cout<<"  "<<name<<": ";
+        if (std::isnan(d)) std::cout<<"not supported"; else std::cout<<d<<" bps";
+        std::cout<<(pass ? "" : "  FAIL")<<"\n";
+      };
+      std::cout<<"IS kernels vs scalar loop ("<<F.size()<<" fills, active "<<to_string(active_simd_level())<<"):\n";
+      std::cout.setf(std::ios::scientific); std::cout.precision(2);
+      line("scalar  ", c.scalar);
+      line("avx2    ", c.avx2);
+      line("avx512  ", c.avx512);
+      line("parallel", c.parallel);
+
+      // Deterministic reductions: 1 and det_threads workers must agree bit for bit.
+      auto bits = [](double a, double b){ return std::bit_cast<std::uint64_t>(a) == std::bit_cast<std::uint64_t>(b); };
+      auto same_all = [&](const auto& a, const auto& b){
+        if (a.size()!=b.size()) return false;
+        for (Eigen::Index i=0;i<a.size();++i) if (!bits(a.data()[i], b.data()[i])) return false;
+        return true; };
+      auto same_ne = [&](const NormalEquations& a, const NormalEquations& b){
+        return a.n==b.n && bits(a.yty,b.yty) && same_all(a.XtX,b.XtX) && same_all(a.Xty,b.Xty); };
+      auto same_br = [&](const ISBreakdown& a, const ISBreakdown& b){
+        return bits(a.is_bps,b.is_bps) && bits(a.spread_bps,b.spread_bps) && bits(a.fees_bps,b.fees_bps)
+            && bits(a.timing_bps,b.timing_bps) && bits(a.residual_bps,b.residual_bps); };
+      auto same_attr = [&](const ISAttribution& a, const ISAttribution& b){
+        if (a.venues!=b.venues || a.cells.size()!=b.cells.size() || !same_br(a.total,b.total)) return false;
+        for (std::size_t i=0;i<a.cells.size();++i) {
+          const auto& x = a.cells[i]; const auto& y = b.cells[i];
+          if (x.venue!=y.venue || x.time_bucket!=y.time_bucket || x.size_bucket!=y.size_bucket || x.side!=y.side
+              || x.fills!=y.fills || !bits(x.qty,y.qty) || !bits(x.notional,y.notional) || !same_br(x.contrib,y.contrib))
+            return false;
+        }
+        return true; };
+      const FillColumns C = make_fill_columns(F, M);
+      const ISSums s1 = is_sums_parallel(C, 1), sn = is_sums_parallel(C, det_threads);
+      const bool is_same = bits(s1.qty,sn.qty) && bits(s1.paid,sn.paid) && bits(s1.spread,sn.spread) && bits(s1.fees,sn.fees);
+      const RegrData D = build_temp_impact_design(F, M);
+      const bool gram_same = same_ne(gram_sums(D.X, D.y, 1), gram_sums(D.X, D.y, det_threads))
+          && same_ne(accumulate_temp_impact_parallel(F, M, true, true, 1),
+                     accumulate_temp_impact_parallel(F, M, true, true, det_threads));
+      AttributionSpec aspec; aspec.time_bucket_s = 60.0; aspec.size_edges = {100.0, 300.0}; aspec.by_side = true;
+      const ISAttribution A1 = attribute_is(F, M, p0, aspec, 1);
+      const bool attr_same = same_attr(A1, attribute_is(F, M, p0, aspec, det_threads));
+      auto det = [&](const char* name, bool same) {
+        ok = ok && same;
+        std::cout<<"  "<<name<<": "<<(same ? "identical" : "differ  FAIL")<<"\n"; };
+      std::cout<<"Thread determinism (1 vs "<<det_threads<<" threads, "<<plan_chunks(F.size()).chunks<<" chunks, bitwise):\n";
+      det("IS sums    ", is_same);
+      det("Gram sums  ", gram_same);
+      det("attribution", attr_same);
+      return ok ? 0 : 1;
+    }
+
+    if (cmd == "is-ci") {
+      std::string orders; bool by_fill=false;
+      BootstrapConfig cfg;
+      for (int i=2;i<argc;++i){
+        std::string a=argv[i];
+        if (a=="--orders"&&i+1<argc) orders=argv[++i];
+        else if (a=="--unit"&&i+1<argc) by_fill = (std::string(argv[++i])=="fill");
+        else if (a=="--reps"&&i+1<argc) cfg.replicates=std::stoul(argv[++i]);
+        else if (a=="--seed"&&i+1<argc) cfg.seed=std::stoull(argv[++i]);
+        else if (a=="--threads"&&i+1<argc) cfg.threads=static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (a=="--alpha"&&i+1<argc) cfg.alpha=std::stod(argv[++i]);
+        else if (a=="--equal-weight") cfg.weighting=ISWeighting::Equal;
+      }
+      if (orders.empty()) die("is-ci: need --orders");
+      std::ifstream in(orders);
+      if (!in) throw std::runtime_error("cannot open " + orders);
+      std::vector<ISPartials> units;
+      std::string line;
+      while (std::getline(in, line)) {
+        if (trim(line).empty()) continue;
+        json jl = json::parse(line);
+        auto F = load_fills_csv(jl.at("fills").get<std::string>());
+        auto M = load_snaps_csv(jl.at("mkt").get<std::string>());
+        if (F.empty() || M.empty()) continue;
+        const double p0 = jl.contains("arrival") ? jl.at("arrival").get<double>() : infer_arrival_mid(F, M);
+        if (by_fill) { auto u = is_fill_partials(F, M, p0); units.insert(units.end(), u.begin(), u.end()); }
+        else units.push_back(is_partials(F, M, p0));
+      }
+      auto B = bootstrap_is(units, cfg);
+      std::cout.setf(std::ios::fixed); std::cout.precision(3);
+      std::cout<<"units="<<B.units<<" replicates="<<B.replicates<<" ci="<<(1.0-cfg.alpha)*100<<"%\n";
+      auto row = [](const char* name, const Interval& iv){
+        std::cout<<"  "<<name<<iv.estimate<<"  se "<<iv.se<<"  ["<<iv.lo<<", "<<iv.hi<<"]\n"; };
+      row("IS (bps):    ", B.is);
+      row("Spread:      ", B.spread);
+      row("Fees:        ", B.fees);
+      row("Timing:      ", B.timing);
+      row("Residual:    ", B.residual);
       return 0;
     }
 
     if (cmd == "fit-impact") {
-      std::string fills, mkt; bool sp=true, sg=true;
+      std::string fills, mkt; bool sp=true, sg=true, stream=false; unsigned threads=1; double rls=0.0;
+      std::size_t rolling=0, step=1; double day_s=86400.0;
+      std::vector<double> horizons; double order_gap=60.0, gamma_h=std::numeric_limits<double>::quiet_NaN();
+      bool power_law=false, typed=false, bucketed=false, venue_fe=false;
+      std::size_t boot_reps=0; bool block_orders=false; double block_s=3600.0;
+      BootstrapConfig boot_cfg; boot_cfg.threads=1;
+      bool cv=false; CVOptions cv_opt;
+      std::string storep, sym;
+      bool robust=false; RobustLoss robust_loss=RobustLoss::Huber; double tuning=0.0; std::string outp;
       for (int i=2;i<argc;++i){
         std::string a=argv[i];
         if (a=="--fills"&&i+1<argc) fills=argv[++i];
         else if (a=="--mkt"&&i+1<argc) mkt=argv[++i];
         else if (a=="--no-spread") sp=false;
         else if (a=="--no-sigma")  sg=false;
+        else if (a=="--stream")    stream=true;
+        else if (a=="--rls"&&i+1<argc) rls=std::stod(argv[++i]);
+        else if (a=="--rolling"&&i+1<argc) rolling=std::stoul(argv[++i]);
+        else if (a=="--step"&&i+1<argc) step=std::stoul(argv[++i]);
+        else if (a=="--day-s"&&i+1<argc) day_s=std::stod(argv[++i]);
+        else if (a=="--perm-horizons"&&i+1<argc) horizons=parse_doubles(argv[++i]);
+        else if (a=="--order-gap"&&i+1<argc) order_gap=std::stod(argv[++i]);
+        else if (a=="--gamma-horizon"&&i+1<argc) gamma_h=std::stod(argv[++i]);
+        else if (a=="--power-law") power_law=true;
+        else if (a=="--typed") typed=true;
+        else if (a=="--bucketed") bucketed=true;
+        else if (a=="--venue-fe") venue_fe=true;
+        else if (a=="--robust") robust=true;
+        else if (a=="--cv") cv=true;
+        else if (a=="--store"&&i+1<argc) storep=argv[++i];
+        else if (a=="--symbol"&&i+1<argc) sym=argv[++i];
+        else if (a=="--folds"&&i+1<argc) cv_opt.folds=std::stoul(argv[++i]);
+        else if (a=="--gap-blocks"&&i+1<argc) cv_opt.gap_blocks=std::stoul(argv[++i]);
+        else if (a=="--lambdas"&&i+1<argc) cv_opt.lambdas=parse_doubles(argv[++i]);
+        else if (a=="--bootstrap"&&i+1<argc) boot_reps=std::stoul(argv[++i]);
+        else if (a=="--block"&&i+1<argc) {
+          std::string b=argv[++i];
+          if (b=="order") block_orders=true;
+          else if (b=="time") block_orders=false;
+          else die("fit-impact: --block must be time or order");
+        }
+        else if (a=="--block-s"&&i+1<argc) block_s=std::stod(argv[++i]);
+        else if (a=="--seed"&&i+1<argc) boot_cfg.seed=std::stoull(argv[++i]);
+        else if (a=="--alpha"&&i+1<argc) boot_cfg.alpha=std::stod(argv[++i]);
+        else if (a=="--robust-loss"&&i+1<argc) {
+          std::string l=argv[++i];
+          if (l=="huber") robust_loss=RobustLoss::Huber;
+          else if (l=="tukey") robust_loss=RobustLoss::Tukey;
+          else die("fit-impact: --robust-loss must be huber or tukey");
+        }
+        else if (a=="--tuning"&&i+1<argc) tuning=std::stod(argv[++i]);
+        else if (a=="--out"&&i+1<argc) outp=argv[++i];
+        else if (a=="--threads"&&i+1<argc) threads=static_cast<unsigned>(std::stoul(argv[++i]));
       }
       if (fills.empty()||mkt.empty()) die("fit-impact: need --fills --mkt");
+      if (!storep.empty()) {
+        // Streaming OLS fit, skipped when these exact inputs were fitted before.
+        // Records are keyed by the temp-OLS spec only; other models are not stored.
+        if (sym.empty()) die("fit-impact: --store needs --symbol");
+        if (power_law||robust||venue_fe||cv||typed||bucketed||rolling>0||rls>0.0||!horizons.empty()||boot_reps>0)
+          die("fit-impact: --store only stores the plain OLS fit; drop --power-law/--robust/--venue-fe/"
+              "--cv/--typed/--bucketed/--rolling/--rls/--perm-horizons/--bootstrap");
+        const std::uint64_t spec = spec_hash(temp_impact_spec(sp,sg));
+        const std::uint64_t fp = fingerprint_files({fills, mkt});
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        {
+          ImpactStoreView store(storep);
+          if (const ImpactRecord* r = store.find_input(sym, spec, fp)) {
+            std::cout<<"eta ≈ "<<r->eta_bp_per_10pov<<" bps per 10% POV (cached, n="<<r->n<<")\n";
+            if (!outp.empty()) write_impact_json(outp, r->params());
+            return 0;
+          }
+        }
+        auto F = load_fills_csv(fills);
+        auto M = load_snaps_csv(mkt);
+        if (F.empty()) die("fit-impact: no fills");
+        auto fit = solve_normal_equations(accumulate_temp_impact_parallel(F,M,sp,sg,threads));
+        note_aliased(fit.aliased, sp, sg);
+        upsert_impact_store(storep, make_impact_record(sym, spec, fp, F.front().time, F.back().time, fit));
+        std::cout<<"eta ≈ "<<fit.params.eta_bp_per_10pov<<" bps per 10% POV"
+                 <<" (se "<<fit.se(1)*0.1<<", R2 "<<fit.r2<<", n="<<fit.n<<", stored in "<<storep<<")\n";
+        if (!outp.empty()) write_impact_json(outp, fit.params);
+        return 0;
+      }
+      // One estimator per run: the modes below are exclusive, and --threads
+      // and --out are refused where the chosen mode would ignore them.
+      std::string modes;
+      auto mode = [&](bool on, const char* flag){ if (on) modes += (modes.empty() ? "" : " ") + std::string(flag); };
+      mode(power_law, "--power-law"); mode(!horizons.empty(), "--perm-horizons");
+      mode(rolling>0, "--rolling"); mode(rls>0.0, "--rls"); mode(cv, "--cv"); mode(boot_reps>0, "--bootstrap");
+      mode(robust, "--robust"); mode(venue_fe, "--venue-fe"); mode(typed, "--typed");
+      mode(stream, "--stream"); mode(bucketed, "--bucketed");
+      if (modes.find(' ') != std::string::npos) die("fit-impact: pick one of "+modes);
+      if (threads!=1 && !(stream||cv||boot_reps>0||robust))
+        die("fit-impact: --threads applies to --stream, --store, --cv, --bootstrap and --robust only");
+      if (!outp.empty() && (rolling>0||boot_reps>0))
+        die("fit-impact: --rolling and --bootstrap do not write --out");
       auto F = load_fills_csv(fills);
       auto M = load_snaps_csv(mkt);
-      auto D = build_temp_impact_design(F,M,sp,sg);
+      if (power_law) {
+        PowerLawOptions opt;
+        opt.include_spread_control = sp;
+        opt.include_sigma_control  = sg;
+        auto fit = fit_temporary_impact_power_law(build_impact_columns(F,M), opt);
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        std::cout<<"eta ≈ "<<fit.params.eta_bp_per_10pov<<" bps per 10% POV, beta ≈ "<<fit.params.beta
+                 <<" (LM passes "<<fit.iterations<<(fit.converged?"":", not converged")<<", R2 "<<fit.r2<<")\n";
+        if (!outp.empty()) write_impact_json(outp, fit.params);
+        return 0;
+      }
+      if (!horizons.empty()) {
+        auto D = build_perm_impact_design(split_orders(F, order_gap), M, horizons);
+        auto G = fit_permanent_impact_multi(D);
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        std::cout<<"orders="<<D.X.rows()<<"\n";
+        for (std::size_t h=0; h<G.horizons_s.size(); ++h)
+          std::cout<<"gamma("<<G.horizons_s[h]<<"s) ≈ "<<G.gamma_bp_per_10pov[h]<<" bps per 10% participation\n";
+        if (!outp.empty()) {
+          // impact.json takes one gamma: --gamma-horizon, else the longest
+          // horizon; eta comes from the default temporary-impact fit.
+          std::size_t h = 0;
+          for (std::size_t i=1; i<G.horizons_s.size(); ++i) if (G.horizons_s[i] > G.horizons_s[h]) h = i;
+          if (!std::isnan(gamma_h)) {
+            auto it = std::find(G.horizons_s.begin(), G.horizons_s.end(), gamma_h);
+            if (it == G.horizons_s.end()) die("fit-impact: --gamma-horizon must be one of --perm-horizons");
+            h = static_cast<std::size_t>(it - G.horizons_s.begin());
+          }
+          auto T = build_temp_impact_design(F,M,sp,sg);
+          ImpactParams P = fit_temporary_impact_ols(T.X, T.y);
+          P.gamma_bp_per_10pov = G.gamma_bp_per_10pov[h];
+          write_impact_json(outp, P);
+          std::cout<<"Wrote "<<outp<<" | eta="<<P.eta_bp_per_10pov<<" | gamma("<<G.horizons_s[h]<<"s)="
+                   <<P.gamma_bp_per_10pov<<"\n";
+        }
+        return 0;
+      }
+      if (rolling > 0) {
+        auto pts = rolling_impact_fits(daily_impact_stats(F,M,day_s,sp,sg), rolling, step);
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        std::cout<<"day,eta_bp_per_10pov,se,n\n";
+        for (const auto& p : pts) {
+          if (!p.ok) { std::cout<<p.day<<",,,\n"; continue; }
+          std::cout<<p.day<<","<<p.fit.params.eta_bp_per_10pov<<","<<p.fit.se(1)*0.1<<","<<p.fit.n<<"\n";
+        }
+        return 0;
+      }
+      if (rls > 0.0) {
+        RlsImpactEstimator est(sp, sg, rls);
+        AsOfCursor cur(M);
+        for (const auto& f : F) est.update(f, cur.at(f.time));
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        std::cout<<"eta ≈ "<<est.params().eta_bp_per_10pov<<" bps per 10% POV"
+                 <<" (RLS, lambda "<<rls<<", updates="<<est.updates()<<")\n";
+        if (!outp.empty()) write_impact_json(outp, est.params());
+        return 0;
+      }
+      if (cv) {
+        cv_opt.threads = threads;
+        auto R = cross_validate_impact(daily_impact_stats(F,M,block_s,true,true).ne, cv_opt);
+        std::cout.setf(std::ios::fixed); std::cout.precision(4);
+        std::cout<<"spread,sigma,lambda,rmse_bps,rmse_se\n";
+        for (const auto& p : R.grid)
+          std::cout<<p.spread<<","<<p.sigma<<","<<p.lambda<<","<<p.rmse<<","<<p.rmse_se<<"\n";
+        const auto& b = R.grid[R.best];
+        std::cout.precision(3);
+        std::cout<<"selected: controls="<<(b.spread?"spread":"")<<(b.spread&&b.sigma?"+":"")<<(b.sigma?"sigma":"")
+                 <<((b.spread||b.sigma)?"":"none")<<" lambda="<<b.lambda<<" oos rmse "<<b.rmse<<" bps"
+                 <<" ("<<R.folds<<" folds over "<<R.blocks<<" blocks)\n";
+        std::cout<<"eta ≈ "<<R.fit.params.eta_bp_per_10pov<<" bps per 10% POV\n";
+        note_aliased(R.fit.aliased, b.spread, b.sigma);
+        if (!outp.empty()) write_impact_json(outp, R.fit.params);
+        return 0;
+      }
+      if (boot_reps > 0) {
+        std::vector<NormalEquations> blocks;
+        if (block_orders) {
+          for (const auto& o : split_orders(F, order_gap)) blocks.push_back(accumulate_temp_impact(o,M,sp,sg));
+        } else {
+          blocks = daily_impact_stats(F,M,block_s,sp,sg).ne;
+        }
+        boot_cfg.replicates = boot_reps;
+        boot_cfg.threads = threads;
+        auto B = bootstrap_impact(blocks, boot_cfg);
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        std::cout<<"eta ≈ "<<B.eta.estimate<<" bps per 10% POV (se "<<B.eta.se<<", "
+                 <<(1.0-boot_cfg.alpha)*100<<"% ci ["<<B.eta.lo<<", "<<B.eta.hi<<"])\n";
+        std::cout<<"blocks="<<B.blocks<<" ("<<(block_orders?"orders":"time")<<") replicates="<<B.replicates;
+        if (B.singular) std::cout<<" singular="<<B.singular;
+        std::cout<<"\n";
+        std::vector<std::string> names{"intercept","signed_pov"};
+        if (sp) names.push_back("spread_bps");
+        if (sg) names.push_back("sigma");
+        std::cout<<"coef,estimate,se,lo,hi\n";
+        for (std::size_t c=0; c<B.coef.size(); ++c)
+          std::cout<<names[c]<<","<<B.coef[c].estimate<<","<<B.coef[c].se<<","<<B.coef[c].lo<<","<<B.coef[c].hi<<"\n";
+        return 0;
+      }
+      if (robust) {
+        RobustOptions opt;
+        opt.include_spread_control = sp;
+        opt.include_sigma_control  = sg;
+        opt.loss = robust_loss;
+        opt.tuning = tuning;
+        opt.threads = threads;
+        auto r = fit_temporary_impact_robust(build_impact_columns(F,M), opt);
+        note_aliased(r.fit.aliased, sp, sg);
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        std::cout<<"eta ≈ "<<r.fit.params.eta_bp_per_10pov<<" bps per 10% POV"
+                 <<" (se "<<r.fit.se(1)*0.1<<", "<<to_string(robust_loss)<<" c="<<r.tuning
+                 <<", scale "<<r.scale<<" bps)\n";
+        std::cout<<"IRLS passes "<<r.iterations<<(r.converged?"":", not converged");
+        if (robust_loss==RobustLoss::Tukey) std::cout<<", rejected "<<r.rejected<<"/"<<r.fit.n;
+        else std::cout<<", downweighted "<<r.downweighted<<"/"<<r.fit.n;
+        std::cout<<"\n";
+        if (!outp.empty()) write_impact_json(outp, r.fit.params);
+        return 0;
+      }
+      if (venue_fe) {
+        auto fit = fit_venue_impact(accumulate_venue_impact(F,M,sp,sg));
+        note_aliased(fit.aliased, sp, sg, 1);
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        std::cout<<"eta ≈ "<<fit.params.eta_bp_per_10pov<<" bps per 10% POV"
+                 <<" (se "<<fit.se(0)*0.1<<", within R2 "<<fit.r2_within<<", n="<<fit.n
+                 <<", venues="<<fit.venues.size()<<")\n";
+        std::cout<<"venue,n,alpha_bps,se_bps\n";
+        for (const auto& v : fit.venues)
+          std::cout<<v.venue<<","<<v.n<<","<<v.alpha<<","<<v.se<<"\n";
+        if (!outp.empty()) write_impact_json(outp, fit.params);
+        return 0;
+      }
+      if (typed) {
+        auto fit = fit_temporary_impact_typed(F,M,sp,sg);
+        note_aliased(fit.aliased, sp, sg);
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        std::cout<<"eta ≈ "<<fit.params.eta_bp_per_10pov<<" bps per 10% POV"
+                 <<" (se "<<fit.se(1)*0.1<<", R2 "<<fit.r2<<", n="<<fit.n<<", k="<<fit.coef.size()<<")\n";
+        if (!outp.empty()) write_impact_json(outp, fit.params);
+        return 0;
+      }
+      if (stream) {
+        auto fit = solve_normal_equations(accumulate_temp_impact_parallel(F,M,sp,sg,threads));
+        note_aliased(fit.aliased, sp, sg);
+        std::cout.setf(std::ios::fixed); std::cout.precision(3);
+        std::cout<<"eta ≈ "<<fit.params.eta_bp_per_10pov<<" bps per 10% POV"
+                 <<" (se "<<fit.se(1)*0.1<<", R2 "<<fit.r2<<", n="<<fit.n<<")\n";
+        if (!outp.empty()) write_impact_json(outp, fit.params);
+        return 0;
+      }
+      auto D = bucketed ? build_bucketed_impact_design(F,M,sp,sg) : build_temp_impact_design(F,M,sp,sg);
       auto P = fit_temporary_impact_ols(D.X, D.y);
       std::cout.setf(std::ios::fixed); std::cout.precision(3);
-      std::cout<<"eta ≈ "<<P.eta_bp_per_10pov<<" bps per 10% POV\n";
+      std::cout<<"eta ≈ "<<P.eta_bp_per_10pov<<" bps per 10% POV";
+      if (bucketed) std::cout<<" (bucketed, rows="<<D.X.rows()<<")";
+      std::cout<<"\n";
+      if (!outp.empty()) write_impact_json(outp, P);
+      return 0;
+    }
+
+    if (cmd == "fit-panel") {
+      std::string uni, out="impact_table.json"; bool sp=true, sg=true; unsigned threads=0;
+      for (int i=2;i<argc;++i){
+        std::string a=argv[i];
+        if (a=="--universe"&&i+1<argc) uni=argv[++i];
+        else if (a=="--out"&&i+1<argc) out=argv[++i];
+        else if (a=="--threads"&&i+1<argc) threads=static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (a=="--no-spread") sp=false;
+        else if (a=="--no-sigma")  sg=false;
+      }
+      if (uni.empty()) die("fit-panel: need --universe");
+      auto U = load_universe_jsonl(uni);
+      std::vector<std::string> syms;
+      for (const auto& u : U) syms.push_back(u.symbol);
+      auto P = fit_impact_panel(syms, panel_impact_stats(U, sp, sg, threads));
+      note_aliased(P.pooled.aliased, sp, sg);
+      write_impact_table_json(out, P.table);
+      std::cout.setf(std::ios::fixed); std::cout.precision(3);
+      std::cout<<"Wrote "<<out<<" | symbols="<<P.table.symbols.size()
+               <<" | pooled eta="<<P.pooled.params.eta_bp_per_10pov
+               <<" | RE mean="<<P.mu_eta<<" | tau="<<std::sqrt(P.tau2)<<"\n";
+      return 0;
+    }
+
+    if (cmd == "fit-propagator") {
+      std::string fills, mkt, kernel="both", outp; double dt=1.0; unsigned threads=1;
+      for (int i=2;i<argc;++i){
+        std::string a=argv[i];
+        if (a=="--fills"&&i+1<argc) fills=argv[++i];
+        else if (a=="--mkt"&&i+1<argc) mkt=argv[++i];
+        else if (a=="--dt"&&i+1<argc) dt=std::stod(argv[++i]);
+        else if (a=="--kernel"&&i+1<argc) kernel=argv[++i];
+        else if (a=="--threads"&&i+1<argc) threads=static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (a=="--out"&&i+1<argc) outp=argv[++i];
+      }
+      if (fills.empty()||mkt.empty()) die("fit-propagator: need --fills --mkt");
+      if (kernel!="exp"&&kernel!="power"&&kernel!="both") die("fit-propagator: --kernel must be exp, power or both");
+      auto S = build_propagator_series(load_fills_csv(fills), load_snaps_csv(mkt), dt);
+      auto fit = calibrate_propagator(S, default_kernel_grid(dt, kernel!="power", kernel!="exp"), threads);
+      const auto& K = fit.model.kernel;
+      std::cout.setf(std::ios::fixed); std::cout.precision(3);
+      std::cout<<"kernel="<<to_string(K.kind);
+      if (K.kind==KernelKind::Exponential) std::cout<<" tau="<<K.tau_s<<"s";
+      else std::cout<<" beta="<<K.beta<<" l0="<<K.l0_s<<"s";
+      std::cout<<" kappa ≈ "<<fit.model.kappa<<" bps per unit participation (R2 "<<fit.r2<<", slices="<<fit.n<<")\n";
+      if (!outp.empty()) write_propagator_json(outp, fit.model);
       return 0;
     }
 
     if (cmd == "optimize") {
-      std::string orderp, mktf, impactp, out="schedule.csv";
+      std::string orderp, mktf, impactp, tablep, storep, sym, out="schedule.csv", propp;
+      bool qp=false; ScheduleQPOptions qp_opt;
       for (int i=2;i<argc;++i){
         std::string a=argv[i];
         if (a=="--order"&&i+1<argc) orderp=argv[++i];
         else if (a=="--mkt"&&i+1<argc) mktf=argv[++i];
         else if (a=="--impact"&&i+1<argc) impactp=argv[++i];
+        else if (a=="--impact-table"&&i+1<argc) tablep=argv[++i];
+        else if (a=="--store"&&i+1<argc) storep=argv[++i];
+        else if (a=="--symbol"&&i+1<argc) sym=argv[++i];
         else if (a=="--out"&&i+1<argc) out=argv[++i];
+        else if (a=="--propagator"&&i+1<argc) propp=argv[++i];
+        else if (a=="--qp") qp=true;
+        else if (a=="--qp-tol"&&i+1<argc) { qp_opt.eps_abs=std::stod(argv[++i]); qp_opt.eps_rel=qp_opt.eps_abs*100.0; }
       }
-      if (orderp.empty()||mktf.empty()||impactp.empty()) die("optimize: need --order --mkt --impact");
+      if (orderp.empty()||mktf.empty()||(impactp.empty()&&tablep.empty()&&storep.empty())) die("optimize: need --order --mkt --impact");
       // read JSON files
       auto read_json = [](const std::string& path){ std::ifstream in(path); if(!in) throw std::runtime_error("cannot open " + path); json j; in>>j; return j; };
-      json jo = read_json(orderp), ji = read_json(impactp);
-      OrderSpec spec;
-      spec.side = (jo.value("side","BUY")=="SELL")?Side::SELL:Side::BUY;
-      spec.qty  = jo.at("qty").get<double>();
-      spec.horizon_s = jo.value("horizon_s",0.0);
-      spec.slices    = jo.at("slices").get<int>();
-      spec.max_pov   = jo.value("max_pov",1.0);
-      spec.risk_lambda = jo.value("risk_lambda",0.0);
-      ImpactParams ip;
-      ip.eta_bp_per_10pov   = ji.value("eta_bp_per_10pov",0.0);
-      ip.gamma_bp_per_10pov = ji.value("gamma_bp_per_10pov",0.0);
+      OrderSpec spec = order_spec_from_json(read_json(orderp));
+      ImpactParams ip = load_impact(impactp, tablep, storep, sym);
       auto M = load_snaps_csv(mktf);
       if ((int)M.size()!=spec.slices) die("mkt.csv rows must equal order.slices");
 
-      auto sch = optimize_schedule(spec, M, ip);
+      Schedule sch;
+      ScheduleCost cost;
+      std::string how;
+      // Without --qp the closed form is used unless POV floors or caps bind,
+      // as in optimize_schedule.
+      auto ac = almgren_chriss_schedule(spec, M, ip);
+      if (qp || pov_bounds_bind(spec, M, ac)) {
+        auto r = optimize_schedule_qp(spec, M, ip, qp_opt);
+        sch = std::move(r.schedule); cost = r.cost;
+        how = std::string(qp ? "" : "POV bounds bind, QP; ")
+            + "ADMM iterations " + std::to_string(r.iterations) + (r.polished ? ", polished" : r.converged ? "" : ", not converged");
+      } else {
+        sch = std::move(ac.schedule); cost = ac.cost;
+        how = "kappa " + std::to_string(ac.kappa) + "/s";
+      }
       write_schedule_csv(out, sch);
       double tot=0; for(double v:sch.x) tot+=v;
       std::cout<<"Wrote "<<out<<" | slices="<<sch.x.size()<<" | sum="<<tot<<"\n";
+      if (!sch.feasible && sch.shortfall > 0.0)
+        std::cerr<<"warning: POV caps cannot absorb the order; short "<<sch.shortfall<<" shares\n";
+      else if (!sch.feasible)
+        std::cerr<<"warning: POV floors exceed the order; floors scaled down to fit\n";
+      std::cout<<"expected cost ≈ "<<cost.expected_cost_bps<<" bps, sd "<<std::sqrt(cost.variance_bps2)
+               <<" bps ("<<how<<")\n";
+      if (!propp.empty()) {
+        auto pc = propagator_cost(load_propagator_json(propp), spec, M, sch);
+        // Evaluation only: the schedule above was not optimized against the propagator.
+        std::cout<<"transient impact cost of this schedule ≈ "<<pc.cost_bps<<" bps (evaluated, not optimized)\n";
+      }
       return 0;
     }
 
+    if (cmd == "optimize-batch") {
+      std::string ordersp, mktdir, impactp, tablep, storep, out="schedules.csv";
+      BatchOptions bo;
+      for (int i=2;i<argc;++i){
+        std::string a=argv[i];
+        if (a=="--orders"&&i+1<argc) ordersp=argv[++i];
+        else if (a=="--mkt-dir"&&i+1<argc) mktdir=argv[++i];
+        else if (a=="--impact"&&i+1<argc) impactp=argv[++i];
+        else if (a=="--impact-table"&&i+1<argc) tablep=argv[++i];
+        else if (a=="--store"&&i+1<argc) storep=argv[++i];
+        else if (a=="--out"&&i+1<argc) out=argv[++i];
+        else if (a=="--qp") bo.qp=true;
+        else if (a=="--qp-tol"&&i+1<argc) { bo.qp_opt.eps_abs=std::stod(argv[++i]); bo.qp_opt.eps_rel=bo.qp_opt.eps_abs*100.0; }
+        else if (a=="--threads"&&i+1<argc) bo.threads=static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (a=="--grain"&&i+1<argc) bo.grain=std::stoul(argv[++i]);
+      }
+      if (ordersp.empty()||mktdir.empty()||(impactp.empty()&&tablep.empty()&&storep.empty()))
+        die("optimize-batch: need --orders --mkt-dir --impact");
+      auto orders = load_orders_jsonl(ordersp);
+      auto market = load_batch_forecasts(orders, mktdir, bo.threads);
+
+      // Impact per symbol: open the table or store once, not per order.
+      if (!storep.empty()) {
+        ImpactStoreView store(storep);
+        for (std::size_t k=0;k<market.symbols.size();++k) {
+          try { market.impact[k] = stored_impact(store, storep, market.symbols[k]); }
+          catch (const std::exception& ex) { if (market.error[k].empty()) market.error[k] = ex.what(); }
+        }
+      } else if (!tablep.empty()) {
+        auto T = load_impact_table_json(tablep);
+        std::size_t missing = 0;
+        for (std::size_t k=0;k<market.symbols.size();++k) {
+          const ImpactParams* q = T.find(market.symbols[k]);
+          if (!q) ++missing;
+          market.impact[k] = q ? *q : T.pooled;
+        }
+        if (missing)
+          std::cerr<<"warning: "<<missing<<" symbol(s) not in "<<tablep<<"; using its pooled params\n";
+      } else {
+        std::fill(market.impact.begin(), market.impact.end(), load_impact_json(impactp));
+      }
+      const auto nonlinear = std::count_if(market.impact.begin(), market.impact.end(), nonlinear_beta);
+      if (nonlinear)
+        std::cerr<<"warning: impact beta != 1 for "<<nonlinear<<" symbol(s) is ignored;"
+                 <<" the optimizer and cost model are linear in POV\n";
+
+      std::ofstream os(out);
+      if (!os) die("cannot write " + out);
+      auto sum = optimize_batch(orders, market, bo, os, std::cerr);
+      std::cout<<"Wrote "<<out<<" | orders="<<sum.written<<"/"<<sum.orders<<" | rows="<<sum.rows
+               <<" | symbols="<<market.symbols.size()<<"\n";
+      if (sum.infeasible)
+        std::cerr<<"warning: "<<sum.infeasible<<" orders cannot meet their POV caps/floors\n";
+      if (sum.failed) std::cerr<<"warning: "<<sum.failed<<" orders failed (see above)\n";
+      return sum.failed ? 1 : 0;
+    }
+
     if (cmd == "report") {
       // end-to-end: IS + eta + schedule + JSON/CSV outputs
-      std::string sym="UNKNOWN", fills, mkt, impactp, orderp, out="report.json", sched="schedule.csv", iscsv="";
-      double p0 = 0.0;
+      std::string sym, fills, mkt, impactp, tablep, storep, orderp, out="report.json", sched="schedule.csv", iscsv="", attribcsv="";
+      double p0 = 0.0, pc = 0.0;
+      AttributionSpec aspec; bool attrib = false; unsigned threads = 1;
       for (int i=2;i<argc;++i){
         std::string a=argv[i];
         if (a=="--symbol"&&i+1<argc) sym=argv[++i];
@@ -115,47 +723,56 @@ int main(int argc, char** argv) {
         else if (a=="--mkt"&&i+1<argc) mkt=argv[++i];
         else if (a=="--arrival"&&i+1<argc) p0=std::stod(argv[++i]);
         else if (a=="--impact"&&i+1<argc) impactp=argv[++i];
+        else if (a=="--impact-table"&&i+1<argc) tablep=argv[++i];
+        else if (a=="--store"&&i+1<argc) storep=argv[++i];
         else if (a=="--order"&&i+1<argc) orderp=argv[++i];
         else if (a=="--out"&&i+1<argc) out=argv[++i];
         else if (a=="--sched"&&i+1<argc) sched=argv[++i];
         else if (a=="--is"&&i+1<argc) iscsv=argv[++i];
+        else if (a=="--prev-close"&&i+1<argc) pc=std::stod(argv[++i]);
+        else if (a=="--attrib"&&i+1<argc) { attribcsv=argv[++i]; attrib=true; }
+        else if (a=="--bucket-s"&&i+1<argc) { aspec.time_bucket_s=std::stod(argv[++i]); attrib=true; }
+        else if (a=="--size-edges"&&i+1<argc) { aspec.size_edges=parse_doubles(argv[++i]); attrib=true; }
+        else if (a=="--by-side") { aspec.by_side=true; attrib=true; }
+        else if (a=="--no-venue") { aspec.by_venue=false; attrib=true; }
+        else if (a=="--threads"&&i+1<argc) threads=static_cast<unsigned>(std::stoul(argv[++i]));
       }
-      if (fills.empty()||mkt.empty()||impactp.empty()||orderp.empty()||p0<=0.0) {
+      std::sort(aspec.size_edges.begin(), aspec.size_edges.end());
+      if (fills.empty()||mkt.empty()||(impactp.empty()&&tablep.empty()&&storep.empty())||orderp.empty()||p0<=0.0) {
         die("report: need --symbol --fills --mkt --arrival --impact --order");
       }
       auto F = load_fills_csv(fills);
       auto M = load_snaps_csv(mkt);
       // parse JSONs
       auto read_json = [](const std::string& path){ std::ifstream in(path); if(!in) throw std::runtime_error("cannot open " + path); json j; in>>j; return j; };
-      json ji = read_json(impactp), jo = read_json(orderp);
-
-      ImpactParams ip;
-      ip.eta_bp_per_10pov   = ji.value("eta_bp_per_10pov",0.0);
-      ip.gamma_bp_per_10pov = ji.value("gamma_bp_per_10pov",0.0);
+      OrderSpec spec = order_spec_from_json(read_json(orderp));
 
-      OrderSpec spec;
-      spec.side = (jo.value("side","BUY")=="SELL")?Side::SELL:Side::BUY;
-      spec.qty  = jo.at("qty").get<double>();
-      spec.slices = jo.at("slices").get<int>();
-      spec.max_pov = jo.value("max_pov",1.0);
-      spec.risk_lambda = jo.value("risk_lambda",0.0);
+      ImpactParams ip = load_impact(impactp, tablep, storep, sym);
 
       // compute pieces
       TCAReport R;
-      R.symbol = sym;
+      R.symbol = sym.empty() ? "UNKNOWN" : sym;
       R.arrival_mid = p0;
-      R.is = compute_is(F, M, p0);
+      R.benchmarks = compute_is_benchmarks(F, M, p0, pc);
+      R.is = R.benchmarks.arrival;
+      if (attrib) R.attribution = attribute_is(F, M, p0, aspec, threads);
       R.impact = ip;
       if ((int)M.size()!=spec.slices) die("mkt.csv rows must equal order.slices");
       R.schedule = optimize_schedule(spec, M, ip);
+      if (!R.schedule.feasible && R.schedule.shortfall > 0.0)
+        std::cerr<<"warning: POV caps cannot absorb the order; short "<<R.schedule.shortfall<<" shares\n";
+      else if (!R.schedule.feasible)
+        std::cerr<<"warning: POV floors exceed the order; floors scaled down to fit\n";
 
       // write outputs
       write_report_json(out, R, true);
       write_schedule_csv(sched, R.schedule);
       if (!iscsv.empty()) write_is_csv(iscsv, R.is);
+      if (!attribcsv.empty()) write_attribution_csv(attribcsv, R.attribution);
 
       std::cout<<"Wrote "<<out<<" and "<<sched;
       if(!iscsv.empty()) std::cout<<" and "<<iscsv;
+      if(!attribcsv.empty()) std::cout<<" and "<<attribcsv;
       std::cout<<"\n";
       return 0;
     }